@@ -0,0 +1,58 @@
+#include "ConfigWatcher.h"
+#include <QFileInfo>
+#include <QSettings>
+
+ConfigWatcher::ConfigWatcher(const AppConfig& initial, QObject* parent)
+    : QObject(parent)
+    , m_path(configFilePath())
+    , m_current(initial)
+{
+    m_debounce.setSingleShot(true);
+    m_debounce.setInterval(250);
+    connect(&m_debounce, &QTimer::timeout, this, &ConfigWatcher::reload);
+
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, [this]() {
+        m_debounce.start();
+    });
+
+    // A file that was moved away or deleted drops out of the watch; it is
+    // picked up again once it reappears in its directory
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, [this]() {
+        if (!m_watcher.files().contains(m_path) && QFile::exists(m_path))
+            m_debounce.start();
+    });
+    const QString dir = QFileInfo(m_path).absolutePath();
+    if (!m_watcher.addPath(dir))
+        qWarning().noquote() << "[Config] Cannot watch" << dir;
+
+    watch();
+}
+
+void ConfigWatcher::watch()
+{
+    if (m_watcher.files().contains(m_path) || !QFile::exists(m_path)) return;
+    if (!m_watcher.addPath(m_path))
+        qWarning().noquote() << "[Config] Cannot watch" << m_path;
+}
+
+void ConfigWatcher::reload()
+{
+    watch();
+
+    // Caught mid-save (truncated, renamed away) or unreadable: keep what is
+    // applied instead of falling back to the defaults. Finishing the save
+    // triggers another reload.
+    const QFileInfo info(m_path);
+    if (!info.exists() || info.size() == 0) {
+        qWarning().noquote() << "[Config]" << m_path << "is missing or empty, keeping the current settings";
+        return;
+    }
+    if (QSettings(m_path, QSettings::IniFormat).status() != QSettings::NoError) {
+        qWarning().noquote() << "[Config] Cannot read" << m_path << "- keeping the current settings";
+        return;
+    }
+
+    qDebug().noquote() << "[Config] Reloading" << m_path;
+    m_current = loadConfig();
+    emit changed(m_current);
+}
@@ -0,0 +1,39 @@
+#ifndef CONFIGWATCHER_H
+#define CONFIGWATCHER_H
+
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QTimer>
+#include "config.h"
+
+// Reloads config.ini when it changes on disk and emits the new settings.
+//
+// Bursts of file events (editors often truncate, write and rename) are
+// debounced into one reload. The watch is renewed after every event since
+// a rename-over replaces the watched file, and the file's directory is
+// watched so a file that was moved away is picked up when it returns. A
+// reload that finds the file missing, empty or unreadable keeps the
+// current settings.
+class ConfigWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ConfigWatcher(const AppConfig& initial, QObject* parent = nullptr);
+
+    const AppConfig& current() const { return m_current; }
+
+signals:
+    void changed(const AppConfig& config);
+
+private:
+    void watch();
+    void reload();
+
+    QString            m_path;
+    AppConfig          m_current;
+    QFileSystemWatcher m_watcher;
+    QTimer             m_debounce;
+};
+
+#endif // CONFIGWATCHER_H
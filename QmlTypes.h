@@ -0,0 +1,50 @@
+#ifndef QMLTYPES_H
+#define QMLTYPES_H
+
+#include <QQmlEngine>
+#include "auth/AuthManager.h"
+#include "auth/AuthState.h"
+#include "auth/PermissionHandle.h"
+#include "auth/PermissionManager.h"
+
+// PoCAuthCore does not depend on QML; its types are exposed to the
+// PoCAuthSystem module from here under their own names.
+
+struct AuthManagerForeign
+{
+    Q_GADGET
+    QML_FOREIGN(AuthManager)
+    QML_NAMED_ELEMENT(AuthManager)
+    QML_SINGLETON
+
+public:
+    static AuthManager* create(QQmlEngine*, QJSEngine*) { return new AuthManager; }
+};
+
+struct PermissionManagerForeign
+{
+    Q_GADGET
+    QML_FOREIGN(PermissionManager)
+    QML_NAMED_ELEMENT(PermissionManager)
+    QML_SINGLETON
+
+public:
+    static PermissionManager* create(QQmlEngine*, QJSEngine*) { return new PermissionManager; }
+};
+
+struct PermissionHandleForeign
+{
+    Q_GADGET
+    QML_FOREIGN(PermissionHandle)
+    QML_NAMED_ELEMENT(PermissionHandle)
+    QML_UNCREATABLE("Obtain handles from PermissionManager.handle().")
+};
+
+namespace AuthStateEnumForeign
+{
+    Q_NAMESPACE
+    QML_FOREIGN_NAMESPACE(AuthStateEnum)
+    QML_NAMED_ELEMENT(AuthStateEnum)
+}
+
+#endif // QMLTYPES_H
@@ -6,30 +6,36 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QDateTime>
+#include <limits>
 
 AuthManager::AuthManager(QObject* parent)
     : QObject(parent)
 {
     m_refreshTimer.setSingleShot(true);
     connect(&m_refreshTimer, &QTimer::timeout, this, [this]() {
-        if (m_state != AuthState::Authenticated || !m_api) return;
-
+        // A far-off expiry takes several timer runs to reach
+        if (m_expiresAt - QDateTime::currentSecsSinceEpoch() - m_refreshMarginSec > MinRefreshDelaySec) {
+            scheduleTokenRefresh();
+            return;
+        }
         qDebug() << "[AuthManager] Token refresh timer fired";
-
-        m_api->refresh(m_tokens.refreshToken,
-            [this](const LoginResult& result) {
-                handleLoginResult(result);
-                qDebug() << "[AuthManager] Token refreshed successfully";
-            },
-            [this](const ErrorResult& err) {
-                qWarning() << "[AuthManager] Token refresh failed:" << err.message;
-                clearSession();
-                setState(AuthState::Unauthenticated);
-                emit sessionExpired();
-            });
+        refreshSession({});
     });
 }
 
+void AuthManager::setTokenVerificationKey(const QByteArray& key)
+{
+    m_jwt.setVerificationKey(key);
+}
+
+void AuthManager::setRefreshMargin(int seconds)
+{
+    if (m_refreshMarginSec == seconds) return;
+    m_refreshMarginSec = seconds;
+    if (m_state == AuthState::Authenticated)
+        scheduleTokenRefresh();
+}
+
 void AuthManager::initialize(AuthApi* api,
                               SecureTokenStorage* storage,
                               PermissionManager* permissions)
@@ -57,7 +63,13 @@ void AuthManager::login(const QString& username, const QString& password)
 
     m_api->login(username, password,
         [this](const LoginResult& result) {
-            handleLoginResult(result);
+            QString error;
+            if (!handleLoginResult(result, error)) {
+                qWarning() << "[AuthManager] Login failed:" << error;
+                handleAuthError(error);
+                emit loginFailed(error);
+                return;
+            }
             emit loginSucceeded();
             qDebug() << "[AuthManager] Login succeeded for" << m_session.username;
         },
@@ -104,21 +116,28 @@ void AuthManager::tryAutoLogin()
         return;
     }
 
-    const qint64 expiresAt = m_storage->loadExpiresAt();
+    // The token's own exp claim is exact; the stored estimate only covers
+    // opaque tokens
+    JwtClaims claims;
+    const bool isJwt = m_jwt.decode(stored.accessToken, claims) == JwtDecoder::Ok;
+    const qint64 expiresAt = isJwt ? claims.expiresAt : m_storage->loadExpiresAt();
     const qint64 now       = QDateTime::currentSecsSinceEpoch();
-    const qint64 margin    = 120;
+    const qint64 margin    = m_refreshMarginSec;
 
     if (expiresAt - now > margin) {
         qDebug() << "[AuthManager] Access token still valid for" << (expiresAt - now) << "seconds, skipping refresh";
 
         LoginResult result;
         result.tokens = stored;
-        result.user   = m_storage->loadUserSession();
+        if (!isJwt) result.user = m_storage->loadUserSession();
 
         setState(AuthState::AutoLoggingIn);
-        handleLoginResult(result);
-        emit loginSucceeded();
-        return;
+        QString error;
+        if (handleLoginResult(result, error)) {
+            emit loginSucceeded();
+            return;
+        }
+        qWarning() << "[AuthManager] Stored token rejected:" << error;
     }
 
     setState(AuthState::AutoLoggingIn);
@@ -126,7 +145,13 @@ void AuthManager::tryAutoLogin()
 
     m_api->refresh(stored.refreshToken,
         [this](const LoginResult& result) {
-            handleLoginResult(result);
+            QString error;
+            if (!handleLoginResult(result, error)) {
+                qWarning() << "[AuthManager] Auto-login failed:" << error;
+                if (m_storage) m_storage->clearAll();
+                setState(AuthState::Unauthenticated);
+                return;
+            }
             emit loginSucceeded();
             qDebug() << "[AuthManager] Auto-login succeeded for" << m_session.username;
         },
@@ -137,6 +162,47 @@ void AuthManager::tryAutoLogin()
         });
 }
 
+void AuthManager::refreshSession(std::function<void(bool)> done)
+{
+    if (m_state != AuthState::Authenticated || !m_api) {
+        if (done) done(false);
+        return;
+    }
+
+    if (done) m_refreshWaiters.append(std::move(done));
+    if (m_refreshing) return;
+    m_refreshing = true;
+
+    const auto finish = [this](bool refreshed) {
+        m_refreshing = false;
+        const QList<std::function<void(bool)>> waiters = std::exchange(m_refreshWaiters, {});
+        for (const auto& waiter : waiters)
+            waiter(refreshed);
+    };
+
+    const auto expire = [this, finish](const QString& message) {
+        qWarning() << "[AuthManager] Token refresh failed:" << message;
+        clearSession();
+        setState(AuthState::Unauthenticated);
+        emit sessionExpired();
+        finish(false);
+    };
+
+    m_api->refresh(m_tokens.refreshToken,
+        [this, finish, expire](const LoginResult& result) {
+            QString error;
+            if (!handleLoginResult(result, error)) {
+                expire(error);
+                return;
+            }
+            qDebug() << "[AuthManager] Token refreshed successfully";
+            finish(true);
+        },
+        [expire](const ErrorResult& err) {
+            expire(err.message);
+        });
+}
+
 void AuthManager::setState(AuthState newState)
 {
     if (m_state == newState) return;
@@ -144,14 +210,31 @@ void AuthManager::setState(AuthState newState)
     emit stateChanged();
 }
 
-void AuthManager::handleLoginResult(const LoginResult& result)
+bool AuthManager::handleLoginResult(const LoginResult& result, QString& error)
 {
+    // Session and expiry come from the access token itself. A token that is
+    // not a JWT falls back to the user and expiresIn sent next to it, unless
+    // signatures are verified, in which case anything unverified is refused.
+    JwtClaims claims;
+    const JwtDecoder::Result decoded = m_jwt.decode(result.tokens.accessToken, claims);
+    if (decoded != JwtDecoder::Ok && (m_jwt.verifiesSignatures() || decoded != JwtDecoder::Malformed)) {
+        error = QStringLiteral("Access token rejected: %1").arg(JwtDecoder::resultName(decoded));
+        return false;
+    }
+
     m_tokens = result.tokens;
-    m_session = result.user;
+    if (decoded == JwtDecoder::Ok) {
+        m_session = claims.toSession();
+        m_expiresAt = claims.expiresAt;
+    } else {
+        m_session = result.user;
+        m_expiresAt = m_tokens.expiresIn > 0 ? QDateTime::currentSecsSinceEpoch() + m_tokens.expiresIn : 0;
+    }
 
     if (m_storage) {
         m_storage->saveTokens(m_tokens);
-        m_storage->saveUserSession(m_session);
+        if (decoded != JwtDecoder::Ok)
+            m_storage->saveUserSession(m_session);
     }
 
     if (m_permissions) {
@@ -164,6 +247,7 @@ void AuthManager::handleLoginResult(const LoginResult& result)
 
     emit userChanged();
     setState(AuthState::Authenticated);
+    return true;
 }
 
 void AuthManager::handleAuthError(const QString& message)
@@ -177,12 +261,14 @@ void AuthManager::scheduleTokenRefresh()
 {
     m_refreshTimer.stop();
 
-    if (m_tokens.expiresIn <= 0) return;
+    if (m_expiresAt <= 0) return;
 
-    int refreshInMs = qMax(10, m_tokens.expiresIn - 120) * 1000;
+    const qint64 remaining = m_expiresAt - QDateTime::currentSecsSinceEpoch();
+    const qint64 refreshInSec = qMax<qint64>(MinRefreshDelaySec, remaining - m_refreshMarginSec);
 
-    qDebug() << "[AuthManager] Scheduling token refresh in" << refreshInMs / 1000 << "seconds";
-    m_refreshTimer.start(refreshInMs);
+    qDebug() << "[AuthManager] Scheduling token refresh in" << refreshInSec << "seconds";
+    // QTimer takes an int; the timer re-arms for whatever is left
+    m_refreshTimer.start(int(qMin<qint64>(refreshInSec, std::numeric_limits<int>::max() / 1000) * 1000));
 }
 
 void AuthManager::clearSession()
@@ -190,6 +276,7 @@ void AuthManager::clearSession()
     m_refreshTimer.stop();
     m_tokens.clear();
     m_session.clear();
+    m_expiresAt = 0;
     m_errorMessage.clear();
 
     if (m_storage) m_storage->clearAll();
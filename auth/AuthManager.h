@@ -3,8 +3,9 @@
 
 #include <QObject>
 #include <QTimer>
-#include <QQmlEngine>
+#include <functional>
 #include "AuthState.h"
+#include "JwtDecoder.h"
 #include "entities/UserSession.h"
 #include "entities/AuthTokens.h"
 
@@ -16,8 +17,6 @@ struct LoginResult;
 class AuthManager : public QObject
 {
     Q_OBJECT
-    QML_ELEMENT
-    QML_SINGLETON
 
     Q_PROPERTY(AuthState state READ state NOTIFY stateChanged)
     Q_PROPERTY(QString errorMessage READ errorMessage NOTIFY errorMessageChanged)
@@ -34,6 +33,12 @@ public:
                     SecureTokenStorage* storage,
                     PermissionManager* permissions);
 
+    // HMAC key access tokens must be signed with; empty disables checking
+    void setTokenVerificationKey(const QByteArray& key);
+
+    // How long before expiry the access token is renewed
+    void setRefreshMargin(int seconds);
+
     Q_INVOKABLE void login(const QString& username, const QString& password);
     Q_INVOKABLE void logout();
     Q_INVOKABLE void tryAutoLogin();
@@ -48,6 +53,11 @@ public:
 
     QString accessToken() const;
 
+    // Renews the access token with the stored refresh token. Calls made
+    // while a refresh is running join it; `done` reports whether the
+    // session survived. On failure the session is cleared.
+    void refreshSession(std::function<void(bool refreshed)> done);
+
 signals:
     void stateChanged();
     void errorMessageChanged();
@@ -59,8 +69,11 @@ signals:
     void tokenChanged(const QByteArray& token);
 
 private:
+    // Shortest wait before a scheduled refresh
+    static constexpr qint64 MinRefreshDelaySec = 10;
+
     void setState(AuthState newState);
-    void handleLoginResult(const LoginResult& result);
+    bool handleLoginResult(const LoginResult& result, QString& error);
     void handleAuthError(const QString& message);
     void scheduleTokenRefresh();
     void clearSession();
@@ -72,9 +85,14 @@ private:
     AuthState m_state = AuthState::Initializing;
     QString m_errorMessage;
     QTimer m_refreshTimer;
+    bool m_refreshing = false;
+    QList<std::function<void(bool)>> m_refreshWaiters;
 
     UserSession m_session;
     AuthTokens m_tokens;
+    qint64 m_expiresAt = 0;
+    int m_refreshMarginSec = 120;
+    JwtDecoder m_jwt;
 };
 
 #endif // AUTHMANAGER_H
@@ -2,12 +2,10 @@
 #define AUTHSTATE_H
 
 #include <QObject>
-#include <QQmlEngine>
 
 namespace AuthStateEnum
 {
     Q_NAMESPACE
-    QML_ELEMENT
 
     enum Value {
         Initializing = 0,
@@ -0,0 +1,113 @@
+#include "JwtDecoder.h"
+#include <QCryptographicHash>
+#include <QMessageAuthenticationCode>
+
+namespace {
+
+struct JwtHeader
+{
+    QString alg;
+};
+
+bool decodeSegment(QByteArrayView segment, QByteArray& out)
+{
+    auto result = QByteArray::fromBase64Encoding(segment.toByteArray(),
+                                                 QByteArray::Base64UrlEncoding
+                                                 | QByteArray::OmitTrailingEquals
+                                                 | QByteArray::AbortOnBase64DecodingErrors);
+    if (!result) return false;
+    out = std::move(*result);
+    return true;
+}
+
+bool hmacAlgorithm(const QString& alg, QCryptographicHash::Algorithm& hash)
+{
+    if (alg == QLatin1String("HS256")) hash = QCryptographicHash::Sha256;
+    else if (alg == QLatin1String("HS384")) hash = QCryptographicHash::Sha384;
+    else if (alg == QLatin1String("HS512")) hash = QCryptographicHash::Sha512;
+    else return false;
+    return true;
+}
+
+// Compares in time independent of where the first mismatch is
+bool equalDigests(const QByteArray& a, const QByteArray& b)
+{
+    if (a.size() != b.size()) return false;
+    unsigned char diff = 0;
+    for (qsizetype i = 0; i < a.size(); ++i)
+        diff |= static_cast<unsigned char>(a[i] ^ b[i]);
+    return diff == 0;
+}
+
+} // namespace
+
+template<>
+struct JsonCodec::Fields<JwtHeader> {
+    static constexpr auto list = std::tuple{
+        JsonCodec::field("alg", &JwtHeader::alg),
+    };
+};
+
+void JwtDecoder::setVerificationKey(const QByteArray& key)
+{
+    m_key = key;
+    m_cachedToken.clear();
+}
+
+JwtDecoder::Result JwtDecoder::decode(const QString& token, JwtClaims& claims)
+{
+    if (!token.isEmpty() && token == m_cachedToken) {
+        claims = m_cachedClaims;
+        return Ok;
+    }
+
+    const QByteArray raw = token.toLatin1();
+    const qsizetype firstDot = raw.indexOf('.');
+    const qsizetype secondDot = firstDot < 0 ? -1 : raw.indexOf('.', firstDot + 1);
+    if (secondDot < 0 || raw.indexOf('.', secondDot + 1) >= 0)
+        return Malformed;
+
+    const QByteArrayView view(raw);
+    QByteArray headerJson, payloadJson;
+    if (!decodeSegment(view.first(firstDot), headerJson)
+        || !decodeSegment(view.sliced(firstDot + 1, secondDot - firstDot - 1), payloadJson))
+        return Malformed;
+
+    JwtHeader header;
+    if (!JsonCodec::decode(headerJson, header))
+        return Malformed;
+
+    if (!m_key.isEmpty()) {
+        QCryptographicHash::Algorithm hash;
+        if (!hmacAlgorithm(header.alg, hash))
+            return UnsupportedAlgorithm;
+
+        QByteArray signature;
+        if (!decodeSegment(view.sliced(secondDot + 1), signature))
+            return Malformed;
+
+        const QByteArray expected = QMessageAuthenticationCode::hash(view.first(secondDot), m_key, hash);
+        if (!equalDigests(signature, expected))
+            return BadSignature;
+    }
+
+    JwtClaims decoded;
+    if (!JsonCodec::decode(payloadJson, decoded) || !decoded.isValid())
+        return Malformed;
+
+    m_cachedToken = token;
+    m_cachedClaims = decoded;
+    claims = std::move(decoded);
+    return Ok;
+}
+
+const char* JwtDecoder::resultName(Result result)
+{
+    switch (result) {
+    case Ok:                   return "ok";
+    case Malformed:            return "malformed";
+    case UnsupportedAlgorithm: return "unsupported algorithm";
+    case BadSignature:         return "bad signature";
+    }
+    return "unknown";
+}
@@ -0,0 +1,39 @@
+#ifndef JWTDECODER_H
+#define JWTDECODER_H
+
+#include <QByteArray>
+#include <QString>
+#include "entities/JwtClaims.h"
+
+// Decodes access tokens locally instead of relying on the server to echo
+// the user and expiry next to them.
+//
+// The payload is base64url-decoded and read into JwtClaims. Once a
+// verification key is set, the signature must be a valid HS256/HS384/HS512
+// HMAC under that key and any other algorithm is rejected. Without a key
+// the claims are taken as is. The last successfully decoded token is
+// cached, so repeated lookups of the current token cost a string compare.
+class JwtDecoder
+{
+public:
+    enum Result {
+        Ok = 0,
+        Malformed,
+        UnsupportedAlgorithm,
+        BadSignature,
+    };
+
+    void setVerificationKey(const QByteArray& key);
+    bool verifiesSignatures() const { return !m_key.isEmpty(); }
+
+    Result decode(const QString& token, JwtClaims& claims);
+
+    static const char* resultName(Result result);
+
+private:
+    QByteArray m_key;
+    QString    m_cachedToken;
+    JwtClaims  m_cachedClaims;
+};
+
+#endif // JWTDECODER_H
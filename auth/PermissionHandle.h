@@ -0,0 +1,47 @@
+#ifndef PERMISSIONHANDLE_H
+#define PERMISSIONHANDLE_H
+
+#include <QObject>
+
+class PermissionManager;
+
+// Precompiled permission check for QML.
+//
+// Obtained from PermissionManager.handle(name); there is one shared handle
+// per permission. `granted` is cached and grantedChanged fires only when
+// that permission's bit actually flips, so bindings on other permissions
+// are left alone.
+class PermissionHandle : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(QString permission READ permission CONSTANT FINAL)
+    Q_PROPERTY(bool granted READ granted NOTIFY grantedChanged FINAL)
+
+public:
+    QString permission() const { return m_permission; }
+    bool granted() const { return m_granted; }
+    int id() const { return m_id; }
+
+signals:
+    void grantedChanged();
+
+private:
+    friend class PermissionManager;
+
+    PermissionHandle(int id, const QString& permission, QObject* parent)
+        : QObject(parent), m_id(id), m_permission(permission) {}
+
+    void setGranted(bool granted)
+    {
+        if (m_granted == granted) return;
+        m_granted = granted;
+        emit grantedChanged();
+    }
+
+    int m_id;
+    QString m_permission;
+    bool m_granted = false;
+};
+
+#endif // PERMISSIONHANDLE_H
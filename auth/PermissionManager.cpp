@@ -1,39 +1,150 @@
 #include "PermissionManager.h"
 
 PermissionManager::PermissionManager(QObject* parent)
-    : QObject(parent) {}
+    : QObject(parent)
+{
+    publish(std::make_shared<PermissionSnapshot>());
+}
 
 bool PermissionManager::hasPermission(const QString& permission) const
 {
-    return m_permissions.contains(permission);
+    // Names never interned may still be covered by a wildcard grant
+    const auto it = m_ids.constFind(permission);
+    return it != m_ids.cend() ? hasPermission(*it) : m_current->hasPermission(permission);
 }
 
 bool PermissionManager::hasRole(const QString& role) const
 {
-    return m_roles.contains(role);
+    return m_current->hasRole(role);
 }
 
 bool PermissionManager::hasAnyPermission(const QStringList& permissions) const
 {
     for (const auto& p : permissions) {
-        if (m_permissions.contains(p))
+        if (hasPermission(p))
             return true;
     }
     return false;
 }
 
+PermissionHandle* PermissionManager::handle(const QString& permission)
+{
+    const int id = permissionId(permission);
+    PermissionHandle*& h = m_handles[id];
+    if (!h) {
+        // Parented, so the QML garbage collector never takes it
+        h = new PermissionHandle(id, permission, this);
+        h->m_granted = hasPermission(id);
+    }
+    return h;
+}
+
+int PermissionManager::permissionId(const QString& permission)
+{
+    const auto it = m_ids.constFind(permission);
+    if (it != m_ids.cend()) return *it;
+
+    const int id = int(m_names.size());
+    m_ids.insert(permission, id);
+    m_names.append(permission);
+    setGrant(id, matches(permission));
+    return id;
+}
+
+void PermissionManager::setRoleDefinitions(const QHash<QString, QStringList>& definitions)
+{
+    m_roleDefinitions = definitions;
+}
+
 void PermissionManager::loadFromSession(const QStringList& roles, const QStringList& permissions)
 {
-    m_roles = QSet<QString>(roles.begin(), roles.end());
-    m_permissions = QSet<QString>(permissions.begin(), permissions.end());
-    ++m_revision;
+    auto next = std::make_shared<PermissionSnapshot>();
+    QStringList grants = permissions;
+    for (const QString& role : roles)
+        addRole(role, next->m_roles, grants);
+
+    for (const QString& g : std::as_const(grants))
+        next->m_trie.insert(g);
+    publish(std::move(next));
+
+    // Exact grants are also interned so name lookups of them hit the bitset
+    for (const QString& g : std::as_const(grants)) {
+        if (!g.contains(u'*'))
+            permissionId(g);
+    }
+    regrant();
+
     emit permissionsChanged();
 }
 
 void PermissionManager::clear()
 {
-    m_roles.clear();
-    m_permissions.clear();
-    ++m_revision;
+    publish(std::make_shared<PermissionSnapshot>());
+    regrant();
     emit permissionsChanged();
 }
+
+PermissionSnapshotPtr PermissionManager::snapshot() const
+{
+#if defined(__cpp_lib_atomic_shared_ptr)
+    return m_published.load(std::memory_order_acquire);
+#else
+    return std::atomic_load_explicit(&m_published, std::memory_order_acquire);
+#endif
+}
+
+void PermissionManager::publish(std::shared_ptr<PermissionSnapshot> next)
+{
+    next->m_revision = ++m_revision;
+    m_current = next;
+
+    // Readers holding the previous snapshot keep it alive until they drop it
+#if defined(__cpp_lib_atomic_shared_ptr)
+    m_published.store(std::move(next), std::memory_order_release);
+#else
+    std::atomic_store_explicit(&m_published, PermissionSnapshotPtr(std::move(next)),
+                               std::memory_order_release);
+#endif
+}
+
+bool PermissionManager::matches(const QString& permission) const
+{
+    return m_current->hasPermission(permission);
+}
+
+void PermissionManager::addRole(const QString& role, QSet<QString>& roles, QStringList& grants) const
+{
+    // Inherited roles count as held; already-seen roles end inheritance cycles
+    if (roles.contains(role)) return;
+    roles.insert(role);
+
+    for (const QString& g : m_roleDefinitions.value(role)) {
+        if (g.startsWith(u'@'))
+            addRole(g.mid(1), roles, grants);
+        else
+            grants.append(g);
+    }
+}
+
+void PermissionManager::setGrant(int id, bool granted)
+{
+    const qsizetype word = id >> 6;
+    if (word >= m_grants.size())
+        m_grants.resize(word + 1, 0);
+
+    const quint64 bit = quint64(1) << (id & 63);
+    if (granted) m_grants[word] |= bit;
+    else m_grants[word] &= ~bit;
+}
+
+void PermissionManager::regrant()
+{
+    // Only handles whose bit flips are notified
+    for (int id = 0; id < m_names.size(); ++id) {
+        const bool granted = matches(m_names.at(id));
+        if (granted == hasPermission(id)) continue;
+        setGrant(id, granted);
+        if (PermissionHandle* h = m_handles.value(id))
+            h->setGranted(granted);
+    }
+}
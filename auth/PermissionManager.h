@@ -1,16 +1,32 @@
 #ifndef PERMISSIONMANAGER_H
 #define PERMISSIONMANAGER_H
 
+#include <QHash>
+#include <QList>
 #include <QObject>
 #include <QSet>
 #include <QStringList>
-#include <QQmlEngine>
+#include <atomic>
+#include <memory>
+#include "PermissionHandle.h"
+#include "PermissionSnapshot.h"
 
+// Permission names are interned to small integer ids on first use and the
+// current grants are kept as a bitset over those ids, so a check by id is
+// a single bit test. QML binds to per-permission PermissionHandle objects
+// instead of re-running hasPermission() on every revision bump.
+//
+// Grants may be wildcards ("items.*", "*") and roles expand to grants
+// through the role definitions, including other roles ("@viewer"). Both
+// are compiled into a PermissionTrie at loadFromSession(); the trie is
+// consulted once per interned name, not per check.
+//
+// The QObject API is GUI-thread only. Other threads call snapshot(), which
+// returns the current immutable PermissionSnapshot; a new one is swapped
+// in atomically whenever the grants change.
 class PermissionManager : public QObject
 {
     Q_OBJECT
-    QML_ELEMENT
-    QML_SINGLETON
 
     Q_PROPERTY(int revision READ revision NOTIFY permissionsChanged)
 
@@ -21,18 +37,53 @@ public:
     Q_INVOKABLE bool hasRole(const QString& role) const;
     Q_INVOKABLE bool hasAnyPermission(const QStringList& permissions) const;
 
+    // Shared handle for `permission`, created on first request
+    Q_INVOKABLE PermissionHandle* handle(const QString& permission);
+
+    // Stable id for `permission`; unknown names are interned
+    int permissionId(const QString& permission);
+    bool hasPermission(int id) const
+    {
+        const qsizetype word = id >> 6;
+        return id >= 0 && word < m_grants.size() && (m_grants[word] >> (id & 63)) & 1;
+    }
+
+    // role -> grants; a grant of the form "@role" inherits that role
+    void setRoleDefinitions(const QHash<QString, QStringList>& definitions);
+
     void loadFromSession(const QStringList& roles, const QStringList& permissions);
     void clear();
 
+    // Safe to call from any thread
+    PermissionSnapshotPtr snapshot() const;
+
     int revision() const { return m_revision; }
 
 signals:
     void permissionsChanged();
 
 private:
-    QSet<QString> m_permissions;
-    QSet<QString> m_roles;
+    bool matches(const QString& permission) const;
+    void addRole(const QString& role, QSet<QString>& roles, QStringList& grants) const;
+    void publish(std::shared_ptr<PermissionSnapshot> next);
+    void setGrant(int id, bool granted);
+    void regrant();
+
+    QHash<QString, QStringList> m_roleDefinitions;
     int m_revision = 0;
+
+    // GUI-thread reference to the latest snapshot, plus its published copy
+#if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic<PermissionSnapshotPtr> m_published;
+#else
+    PermissionSnapshotPtr m_published;   // only touched via std::atomic_load/store
+#endif
+    PermissionSnapshotPtr m_current;
+
+    QHash<QString, int>             m_ids;
+    QStringList                     m_names;
+    QList<quint64>                  m_grants;
+    QHash<int, PermissionHandle*>   m_handles;
 };
 
 #endif // PERMISSIONMANAGER_H
@@ -0,0 +1,43 @@
+#ifndef PERMISSIONSNAPSHOT_H
+#define PERMISSIONSNAPSHOT_H
+
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include "PermissionTrie.h"
+
+// Immutable view of the grants at one point in time.
+//
+// PermissionManager publishes a new snapshot on every loadFromSession() or
+// clear() and never modifies one afterwards, so a snapshot can be read
+// from any thread without locking. Hold on to the pointer for a whole
+// batch of checks to see one consistent set of grants.
+class PermissionSnapshot
+{
+public:
+    bool hasPermission(QStringView permission) const { return m_trie.matches(permission); }
+    bool hasRole(const QString& role) const { return m_roles.contains(role); }
+
+    bool hasAnyPermission(const QStringList& permissions) const
+    {
+        for (const QString& p : permissions) {
+            if (m_trie.matches(p))
+                return true;
+        }
+        return false;
+    }
+
+    int revision() const { return m_revision; }
+
+private:
+    friend class PermissionManager;
+
+    PermissionTrie m_trie;
+    QSet<QString>  m_roles;
+    int            m_revision = 0;
+};
+
+using PermissionSnapshotPtr = std::shared_ptr<const PermissionSnapshot>;
+
+#endif // PERMISSIONSNAPSHOT_H
@@ -0,0 +1,141 @@
+#include "PermissionTrie.h"
+#include <QHash>
+#include <algorithm>
+#include <utility>
+
+void PermissionTrie::clear()
+{
+    m_grants.clear();
+    m_nodes.clear();
+}
+
+void PermissionTrie::insert(QStringView grant)
+{
+    if (grant.isEmpty()) return;
+    if (m_grants.isEmpty()) m_grants.append(Node{});
+
+    int node = 0;
+    QStringView rest = grant;
+    for (;;) {
+        const qsizetype dot = rest.indexOf(u'.');
+        const QStringView segment = dot < 0 ? rest : rest.first(dot);
+
+        if (segment == u"*") {
+            if (dot < 0) {
+                m_grants[node].anyTail = true;
+                break;
+            }
+            if (m_grants[node].anySegment < 0) {
+                m_grants.append(Node{});
+                m_grants[node].anySegment = int(m_grants.size() - 1);
+            }
+            node = m_grants[node].anySegment;
+        } else {
+            node = child(node, segment);
+        }
+
+        if (dot < 0) {
+            m_grants[node].terminal = true;
+            break;
+        }
+        rest = rest.sliced(dot + 1);
+    }
+    determinise();
+}
+
+bool PermissionTrie::matches(QStringView permission) const
+{
+    if (m_nodes.isEmpty() || permission.isEmpty()) return false;
+
+    // `rest` is the unmatched part of the name; a null view means every
+    // segment has been consumed
+    int node = 0;
+    QStringView rest = permission;
+    for (;;) {
+        const Node& n = m_nodes.at(node);
+        if (rest.isNull()) return n.terminal;
+        if (n.anyTail) return true;
+
+        const qsizetype dot = rest.indexOf(u'.');
+        const QStringView segment = dot < 0 ? rest : rest.first(dot);
+
+        int next = n.anySegment;
+        for (const Edge& e : n.edges) {
+            if (e.label == segment) {
+                next = e.node;
+                break;
+            }
+        }
+        if (next < 0) return false;
+
+        node = next;
+        rest = dot < 0 ? QStringView() : rest.sliced(dot + 1);
+    }
+}
+
+int PermissionTrie::child(int node, QStringView label)
+{
+    for (const Edge& e : std::as_const(m_grants[node].edges)) {
+        if (e.label == label) return e.node;
+    }
+    const int created = int(m_grants.size());
+    m_grants.append(Node{});
+    m_grants[node].edges.append(Edge{ label.toString(), created });
+    return created;
+}
+
+void PermissionTrie::determinise()
+{
+    m_nodes.clear();
+
+    // Subset construction: node i of m_nodes stands for sets[i], a sorted
+    // set of m_grants nodes
+    QList<QList<int>> sets;
+    QHash<QList<int>, int> index;
+    const auto nodeFor = [&](QList<int> set) -> int {
+        std::sort(set.begin(), set.end());
+        set.erase(std::unique(set.begin(), set.end()), set.end());
+        if (const int known = index.value(set, -1); known >= 0) return known;
+
+        const int created = int(m_nodes.size());
+        m_nodes.append(Node{});
+        index.insert(set, created);
+        sets.append(std::move(set));
+        return created;
+    };
+    nodeFor({ 0 });
+
+    for (qsizetype i = 0; i < sets.size(); ++i) {
+        const QList<int> set = sets.at(i);   // sets grows below
+        Node node;
+        QList<int> any;
+        for (int g : set) {
+            const Node& n = m_grants.at(g);
+            node.terminal = node.terminal || n.terminal;
+            node.anyTail = node.anyTail || n.anyTail;
+            if (n.anySegment >= 0) any.append(n.anySegment);
+        }
+
+        // Below a trailing "*" every name matches; nothing to expand
+        if (!node.anyTail) {
+            for (int g : set) {
+                for (const Edge& e : m_grants.at(g).edges) {
+                    const bool seen = std::any_of(node.edges.cbegin(), node.edges.cend(),
+                                                  [&](const Edge& d) { return d.label == e.label; });
+                    if (seen) continue;
+
+                    // A named segment also follows every "*" of the set
+                    QList<int> next = any;
+                    for (int h : set) {
+                        for (const Edge& f : m_grants.at(h).edges) {
+                            if (f.label == e.label) next.append(f.node);
+                        }
+                    }
+                    node.edges.append(Edge{ e.label, nodeFor(std::move(next)) });
+                }
+            }
+            if (!any.isEmpty()) node.anySegment = nodeFor(any);
+        }
+        m_nodes[i] = std::move(node);
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef PERMISSIONTRIE_H
+#define PERMISSIONTRIE_H
+
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+// Set of permission grants matched segment by segment.
+//
+// Permissions are dot-separated paths ("items.write"). A grant is either
+// an exact path or a pattern where "*" stands for one segment in the
+// middle ("*.read") or, as the last segment, for one or more trailing
+// segments ("items.*" covers "items.write" and "items.audit.read"). A
+// lone "*" grants everything.
+//
+// Grants are kept as inserted, where a segment may follow both an exact
+// edge and a "*", and determinised after every insert(): each node of the
+// lookup trie stands for the set of grant nodes a prefix can reach. A
+// lookup then walks one node per segment. Grants are few and inserted
+// once per session, so rebuilding on insert is cheap.
+class PermissionTrie
+{
+public:
+    void clear();
+    void insert(QStringView grant);
+    bool matches(QStringView permission) const;
+
+private:
+    struct Edge {
+        QString label;
+        int node;
+    };
+
+    struct Node {
+        QList<Edge> edges;
+        int anySegment = -1;   // child reached through a middle "*"
+        bool terminal = false; // a grant ends here
+        bool anyTail = false;  // a trailing "*" grant: everything below matches
+    };
+
+    int child(int node, QStringView label);
+    void determinise();
+
+    QList<Node> m_grants;   // as inserted
+    QList<Node> m_nodes;    // one way through per segment; anySegment takes
+                            // the segments no edge is labelled with
+};
+
+#endif // PERMISSIONTRIE_H
@@ -1,80 +1,214 @@
 #include "SecureTokenStorage.h"
-#include <QJsonDocument>
-#include <QJsonObject>
 #include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include "serialization/JsonCodec.h"
+
+namespace {
+
+using Contents = SecureTokenStorage::Contents;
+
+// Previous releases kept everything in the default QSettings "auth" group
+bool readLegacySettings(Contents& stored)
+{
+    QSettings s;
+    s.beginGroup("auth");
+    stored.tokens.accessToken = s.value("accessToken").toString();
+    stored.tokens.refreshToken = s.value("refreshToken").toString();
+    stored.tokens.expiresIn = s.value("expiresIn", 0).toInt();
+    stored.expiresAt = s.value("expiresAt", 0).toLongLong();
+    const QString json = s.value("userSession").toString();
+    s.endGroup();
+
+    if (!json.isEmpty() && !JsonCodec::decode(json.toUtf8(), stored.session))
+        stored.session.clear();
+    return !stored.tokens.refreshToken.isEmpty() || stored.session.isValid();
+}
+
+void dropLegacySettings()
+{
+    QSettings s;
+    s.remove("auth");
+    s.sync();
+}
+
+bool writeFile(const QString& path, const QByteArray& data)
+{
+    if (data.isEmpty())
+        return !QFile::exists(path) || QFile::remove(path);
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // QSaveFile writes to a temporary file and renames it over the target
+    // on commit()
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    if (file.write(data) != data.size()) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+} // namespace
+
+template<>
+struct JsonCodec::Fields<Contents> {
+    static constexpr auto list = std::tuple{
+        JsonCodec::field("tokens",      &Contents::tokens),
+        JsonCodec::field("expiresAt",   &Contents::expiresAt),
+        JsonCodec::field("session",     &Contents::session),
+        JsonCodec::field("tlsSessions", &Contents::tlsSessions),
+    };
+};
+
+QString SecureTokenStorage::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/auth.json";
+}
+
+SecureTokenStorage::Contents SecureTokenStorage::read(const QString& path)
+{
+    Contents stored;
+
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly)) {
+        if (!JsonCodec::decode(file.readAll(), stored)) {
+            qWarning().noquote() << "[SecureTokenStorage] Ignoring unreadable" << path;
+            stored = Contents{};
+        }
+    } else if (readLegacySettings(stored)) {
+        qDebug().noquote() << "[SecureTokenStorage] Migrating settings to" << path;
+        stored.fromLegacySettings = true;
+    }
+    return stored;
+}
 
 SecureTokenStorage::SecureTokenStorage(QObject* parent)
+    : SecureTokenStorage(read(defaultPath()), parent)
+{
+}
+
+SecureTokenStorage::SecureTokenStorage(Contents contents, QObject* parent)
     : QObject(parent)
+    , m_path(defaultPath())
 {
+    // One writer thread keeps flushes in the order they were scheduled
+    m_writer.setMaxThreadCount(1);
+
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(0);
+    connect(&m_flushTimer, &QTimer::timeout, this, &SecureTokenStorage::writeBehind);
+
+    adopt(std::move(contents));
 }
 
-void SecureTokenStorage::saveTokens(const AuthTokens& tokens)
+SecureTokenStorage::~SecureTokenStorage()
+{
+    flush();
+}
+
+void SecureTokenStorage::adopt(Contents&& contents)
 {
-    const qint64 expiresAt = QDateTime::currentSecsSinceEpoch() + tokens.expiresIn;
+    m_tokens = std::move(contents.tokens);
+    m_expiresAt = contents.expiresAt;
+    m_session = std::move(contents.session);
+    m_tlsSessions = std::move(contents.tlsSessions);
 
-    m_settings.beginGroup("auth");
-    m_settings.setValue("accessToken",  tokens.accessToken);
-    m_settings.setValue("refreshToken", tokens.refreshToken);
-    m_settings.setValue("expiresIn",    tokens.expiresIn);
-    m_settings.setValue("expiresAt",    expiresAt);
-    m_settings.endGroup();
-    m_settings.sync();
+    if (contents.fromLegacySettings) {
+        m_dropLegacy = true;
+        scheduleFlush();
+    }
+}
+
+void SecureTokenStorage::saveTokens(const AuthTokens& tokens)
+{
+    m_tokens = tokens;
+    m_expiresAt = QDateTime::currentSecsSinceEpoch() + tokens.expiresIn;
+    scheduleFlush();
 }
 
 AuthTokens SecureTokenStorage::loadTokens() const
 {
-    AuthTokens tokens;
-    QSettings s;
-    s.beginGroup("auth");
-    tokens.accessToken = s.value("accessToken").toString();
-    tokens.refreshToken = s.value("refreshToken").toString();
-    tokens.expiresIn = s.value("expiresIn", 0).toInt();
-    s.endGroup();
-    return tokens;
+    return m_tokens;
 }
 
 void SecureTokenStorage::saveUserSession(const UserSession& session)
 {
-    QJsonDocument doc(session.toJson());
-    m_settings.setValue("auth/userSession", QString::fromUtf8(doc.toJson(QJsonDocument::Compact)));
-    m_settings.sync();
+    m_session = session;
+    scheduleFlush();
 }
 
 UserSession SecureTokenStorage::loadUserSession() const
 {
-    UserSession session;
-    QSettings s;
-    QString json = s.value("auth/userSession").toString();
-    if (!json.isEmpty()) {
-        QJsonDocument doc = QJsonDocument::fromJson(json.toUtf8());
-        if (doc.isObject())
-            session.fromJson(doc.object());
-    }
-    return session;
+    return m_session;
+}
+
+void SecureTokenStorage::saveTlsSessions(const QList<TlsSession>& sessions)
+{
+    m_tlsSessions = sessions;
+    scheduleFlush();
+}
+
+QList<TlsSession> SecureTokenStorage::loadTlsSessions() const
+{
+    return m_tlsSessions;
 }
 
 void SecureTokenStorage::clearAll()
 {
-    m_settings.beginGroup("auth");
-    m_settings.remove("");
-    m_settings.endGroup();
-    m_settings.sync();
+    m_tokens.clear();
+    m_expiresAt = 0;
+    m_session.clear();
+    scheduleFlush();
 }
 
 qint64 SecureTokenStorage::loadExpiresAt() const
 {
-    QSettings s;
-    s.beginGroup("auth");
-    const qint64 expiresAt = s.value("expiresAt", 0).toLongLong();
-    s.endGroup();
-    return expiresAt;
+    return m_expiresAt;
 }
 
 bool SecureTokenStorage::hasStoredTokens() const
 {
-    QSettings s;
-    s.beginGroup("auth");
-    bool has = !s.value("refreshToken").toString().isEmpty();
-    s.endGroup();
-    return has;
+    return !m_tokens.refreshToken.isEmpty();
+}
+
+void SecureTokenStorage::flush()
+{
+    if (m_flushTimer.isActive()) {
+        m_flushTimer.stop();
+        writeBehind();
+    }
+    m_writer.waitForDone();
+}
+
+void SecureTokenStorage::scheduleFlush()
+{
+    if (!m_flushTimer.isActive())
+        m_flushTimer.start();
+}
+
+void SecureTokenStorage::writeBehind()
+{
+    // Encoding the snapshot here is cheap; only the file I/O moves off thread
+    QByteArray data;
+    if (!m_tokens.refreshToken.isEmpty() || !m_tokens.accessToken.isEmpty() || m_session.isValid()
+        || !m_tlsSessions.isEmpty())
+        data = JsonCodec::encode(Contents{ m_tokens, m_expiresAt, m_session, m_tlsSessions });
+
+    const bool dropLegacy = std::exchange(m_dropLegacy, false);
+
+    m_writer.start([path = m_path, data, dropLegacy]() {
+        if (!writeFile(path, data)) {
+            qWarning().noquote() << "[SecureTokenStorage] Failed to write" << path;
+            return;
+        }
+        if (dropLegacy) dropLegacySettings();
+    });
 }
@@ -2,16 +2,44 @@
 #define SECURETOKENSTORAGE_H
 
 #include <QObject>
-#include <QSettings>
+#include <QThreadPool>
+#include <QTimer>
 #include "entities/AuthTokens.h"
+#include "entities/TlsSession.h"
 #include "entities/UserSession.h"
 
+// Persists tokens, the user session and resumable TLS sessions.
+//
+// The in-memory copy is authoritative: loads never touch the disk after
+// construction. Saves update memory and schedule a write-behind flush;
+// saves made in the same event-loop turn are coalesced into one write,
+// done on a background thread with write-then-rename so a crash leaves
+// either the old or the new file, never a torn one.
 class SecureTokenStorage : public QObject
 {
     Q_OBJECT
 
 public:
+    // Everything the storage file holds
+    struct Contents {
+        AuthTokens tokens;
+        qint64 expiresAt = 0;
+        UserSession session;
+        QList<TlsSession> tlsSessions;
+        bool fromLegacySettings = false;   // migrated; rewritten on first flush
+    };
+
+    static QString defaultPath();
+
+    // Reads the file at `path` (or the legacy settings when it is missing).
+    // Touches no QObject, so startup can run it on a worker thread.
+    static Contents read(const QString& path);
+
+    // Reads defaultPath() synchronously
     explicit SecureTokenStorage(QObject* parent = nullptr);
+    // Adopts contents read ahead of time from defaultPath()
+    explicit SecureTokenStorage(Contents contents, QObject* parent = nullptr);
+    ~SecureTokenStorage() override;
 
     void saveTokens(const AuthTokens& tokens);
     AuthTokens loadTokens() const;
@@ -19,13 +47,34 @@ public:
     void saveUserSession(const UserSession& session);
     UserSession loadUserSession() const;
 
+    // Kept across logouts: they identify the server, not the user
+    void saveTlsSessions(const QList<TlsSession>& sessions);
+    QList<TlsSession> loadTlsSessions() const;
+
     void clearAll();
     bool hasStoredTokens() const;
 
     qint64 loadExpiresAt() const;
 
+    // Blocks until everything saved so far is on disk.
+    void flush();
+
+    QString filePath() const { return m_path; }
+
 private:
-    QSettings m_settings;
+    void adopt(Contents&& contents);
+    void scheduleFlush();
+    void writeBehind();
+
+    QString     m_path;
+    AuthTokens  m_tokens;
+    qint64      m_expiresAt = 0;
+    UserSession m_session;
+    QList<TlsSession> m_tlsSessions;
+    bool        m_dropLegacy = false;
+
+    QTimer      m_flushTimer;
+    QThreadPool m_writer;
 };
 
 #endif // SECURETOKENSTORAGE_H
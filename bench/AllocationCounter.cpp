@@ -0,0 +1,72 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Constant-initialised: the first allocations happen before main()
+std::atomic<quint64> g_allocations{ 0 };
+
+inline void counted()
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace
+
+quint64 AllocationCounter::count()
+{
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+
+// The executable's definitions take precedence over libc's
+extern "C" {
+
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+
+void* malloc(std::size_t size) noexcept
+{
+    counted();
+    return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) noexcept
+{
+    counted();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, std::size_t size) noexcept
+{
+    if (size > 0) counted();
+    return __libc_realloc(ptr, size);
+}
+
+} // extern "C"
+
+#else
+
+void* operator new(std::size_t size)
+{
+    counted();
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+// Heap allocations made by the whole process so far, on any thread.
+//
+// With glibc every malloc() is counted, which covers operator new and Qt's
+// containers alike; elsewhere only operator new is. Linking this file into
+// an executable is what installs the counting allocator.
+namespace AllocationCounter {
+
+quint64 count();
+
+} // namespace AllocationCounter
+
+#endif // ALLOCATIONCOUNTER_H
@@ -2,17 +2,43 @@
 #define APP_CONFIG_H
 
 #include <QGuiApplication>
+#include <QDebug>
 #include <QFile>
+#include <QHash>
 #include <QSettings>
+#include "networking/HttpClient.h"
 
 struct AppConfig {
     QString restBaseUrl;
+    QByteArray jwtKey;   // HMAC key for access token signatures; empty = unchecked
+    QHash<QString, QStringList> roles;   // role -> grants, "@role" inherits
+
+    // [network]
+    int transferTimeoutMs = 15000;
+    RetryPolicy retry;   // defaults for GET requests
+    bool networkThread = true;   // HTTP transport off the GUI thread; read at startup
+    bool warmUp = true;          // connect to rest/baseUrl during startup
+    int keepWarmSec = 60;        // re-connect after this long idle; 0 = off
+    QString tlsCaFile;           // extra trusted CA certificates (PEM)
+    double rateLimit = 50;       // requests per second per host
+    int rateBurst = 20;
+
+    // [auth]
+    int refreshMarginSec = 120;   // refresh this long before the token expires
+
+    // [logging]
+    QString logRules;    // QLoggingCategory filter rules
 };
 
-static void ensureUserConfigExists()
+inline QString configFilePath()
+{
+    return QCoreApplication::applicationDirPath() + "/config.ini";
+}
+
+inline void ensureUserConfigExists()
 {
     const QString appDir         = QCoreApplication::applicationDirPath();
-    const QString userCfgPath    = appDir + "/config.ini";
+    const QString userCfgPath    = configFilePath();
     const QString defaultCfgPath = appDir + "/config.default.ini";
 
     if (!QFile::exists(userCfgPath) && QFile::exists(defaultCfgPath)) {
@@ -22,15 +48,85 @@ static void ensureUserConfigExists()
     }
 }
 
-static AppConfig loadConfig()
+// Integer setting within [min, max]; anything else keeps `fallback`
+inline int readBounded(const QSettings& s, const QString& key, int fallback, int min, int max)
 {
-    const QString appDir      = QCoreApplication::applicationDirPath();
-    const QString userCfgPath = appDir + "/config.ini";
+    if (!s.contains(key)) return fallback;
 
-    QSettings s(userCfgPath, QSettings::IniFormat);
+    bool ok = false;
+    const int value = s.value(key).toInt(&ok);
+    if (!ok || value < min || value > max) {
+        qWarning().noquote() << "[Config] Ignoring" << key << "=" << s.value(key).toString()
+                             << QStringLiteral("(expected %1..%2)").arg(min).arg(max);
+        return fallback;
+    }
+    return value;
+}
+
+inline double readBounded(const QSettings& s, const QString& key, double fallback, double min, double max)
+{
+    if (!s.contains(key)) return fallback;
+
+    bool ok = false;
+    const double value = s.value(key).toDouble(&ok);
+    if (!ok || value < min || value > max) {
+        qWarning().noquote() << "[Config] Ignoring" << key << "=" << s.value(key).toString()
+                             << QStringLiteral("(expected %1..%2)").arg(min).arg(max);
+        return fallback;
+    }
+    return value;
+}
+
+inline QString logRulesFor(const QString& level, const QStringList& extra)
+{
+    QStringList rules;
+    const QString l = level.trimmed().toLower();
+    if (l == "info" || l == "warning" || l == "critical") rules << "*.debug=false";
+    if (l == "warning" || l == "critical")                rules << "*.info=false";
+    if (l == "critical")                                  rules << "*.warning=false";
+    if (!l.isEmpty() && l != "debug" && rules.isEmpty())
+        qWarning().noquote() << "[Config] Unknown logging/level" << level;
+
+    for (const QString& r : extra) {
+        if (!r.trimmed().isEmpty()) rules << r.trimmed();
+    }
+    return rules.join('\n');
+}
+
+// Reads config.ini. Values that are missing or fail validation keep their
+// defaults, so a typo never takes a setting out of range.
+inline AppConfig loadConfig()
+{
+    QSettings s(configFilePath(), QSettings::IniFormat);
 
     AppConfig cfg;
     cfg.restBaseUrl = s.value("rest/baseUrl", "http://localhost:7000").toString();
+    cfg.jwtKey      = s.value("auth/jwtKey").toString().toUtf8();
+
+    s.beginGroup("roles");
+    for (const QString& role : s.childKeys()) {
+        QStringList grants;
+        for (const QString& g : s.value(role).toStringList()) {
+            if (!g.trimmed().isEmpty()) grants.append(g.trimmed());
+        }
+        cfg.roles.insert(role, grants);
+    }
+    s.endGroup();
+
+    cfg.transferTimeoutMs  = readBounded(s, "network/transferTimeoutMs", cfg.transferTimeoutMs, 1000, 600000);
+    cfg.retry.maxAttempts  = readBounded(s, "network/retryMaxAttempts", cfg.retry.maxAttempts, 1, 10);
+    cfg.retry.baseDelayMs  = readBounded(s, "network/retryBaseDelayMs", cfg.retry.baseDelayMs, 0, 60000);
+    cfg.retry.multiplier   = readBounded(s, "network/retryMultiplier", cfg.retry.multiplier, 1.0, 10.0);
+    cfg.retry.maxDelayMs   = readBounded(s, "network/retryMaxDelayMs", cfg.retry.maxDelayMs, 0, 300000);
+    cfg.networkThread      = s.value("network/networkThread", cfg.networkThread).toBool();
+    cfg.warmUp             = s.value("network/warmUp", cfg.warmUp).toBool();
+    cfg.keepWarmSec        = readBounded(s, "network/keepWarmSec", cfg.keepWarmSec, 0, 3600);
+    cfg.tlsCaFile          = s.value("network/tlsCaFile").toString();
+    cfg.rateLimit          = readBounded(s, "network/rateLimit", cfg.rateLimit, 0.1, 10000.0);
+    cfg.rateBurst          = readBounded(s, "network/rateBurst", cfg.rateBurst, 1, 1000);
+    cfg.refreshMarginSec   = readBounded(s, "auth/refreshMarginSec", cfg.refreshMarginSec, 0, 3600);
+    cfg.logRules           = logRulesFor(s.value("logging/level").toString(),
+                                         s.value("logging/rules").toStringList());
 
     return cfg;
 }
@@ -2,6 +2,7 @@
 #define AUTHTOKENS_H
 
 #include <QString>
+#include "serialization/JsonCodec.h"
 
 struct AuthTokens {
     QString accessToken;
@@ -18,4 +19,13 @@ struct AuthTokens {
     }
 };
 
+template<>
+struct JsonCodec::Fields<AuthTokens> {
+    static constexpr auto list = std::tuple{
+        JsonCodec::field("accessToken",  &AuthTokens::accessToken),
+        JsonCodec::field("refreshToken", &AuthTokens::refreshToken),
+        JsonCodec::field("expiresIn",    &AuthTokens::expiresIn),
+    };
+};
+
 #endif // AUTHTOKENS_H
@@ -2,30 +2,23 @@
 #define ITEM_H
 
 #include <QString>
-#include <QJsonObject>
-#include "IPersistable.h"
+#include "serialization/JsonCodec.h"
 
-class Item : public IPersistable
+struct Item
 {
-public:
     QString id;
     QString name;
     QString status;
+};
 
-    QJsonObject toJson() const override {
-        QJsonObject obj;
-        obj["id"] = id;
-        obj["name"] = name;
-        obj["status"] = status;
-        return obj;
-    }
-
-    void fromJson(const QJsonObject &obj) override {
-        // id arrives as int from PoCServer, convert to string
-        id = obj["id"].toVariant().toString();
-        name = obj["name"].toString();
-        status = obj["status"].toString();
-    }
+template<>
+struct JsonCodec::Fields<Item> {
+    static constexpr auto list = std::tuple{
+        // id arrives as int from PoCServer, keep its text
+        JsonCodec::field("id",     &Item::id, JsonCodec::NumberAsString),
+        JsonCodec::field("name",   &Item::name),
+        JsonCodec::field("status", &Item::status),
+    };
 };
 
 #endif // ITEM_H
@@ -0,0 +1,198 @@
+#include "ItemStore.h"
+#include <algorithm>
+
+void ItemStore::clear()
+{
+    m_ids.clear();
+    m_names.clear();
+    m_status.clear();
+    m_statusNames.clear();
+}
+
+void ItemStore::reserve(qsizetype rows, qsizetype charsPerRow)
+{
+    // ids from PoCServer are short integers; names dominate the pool
+    m_ids.reserve(rows, rows * 4);
+    m_names.reserve(rows, rows * charsPerRow);
+    m_status.reserve(rows);
+}
+
+void ItemStore::append(const Item& item)
+{
+    append(item.id, item.name, item.status);
+}
+
+void ItemStore::append(QStringView id, QStringView name, QStringView status)
+{
+    m_ids.append(id);
+    m_names.append(name);
+    m_status.append(internStatus(status));
+}
+
+void ItemStore::replace(qsizetype row, const Item& item)
+{
+    replace(row, item.id, item.name, item.status);
+}
+
+void ItemStore::replace(qsizetype row, QStringView id, QStringView name, QStringView status)
+{
+    m_ids.replace(row, id);
+    m_names.replace(row, name);
+    m_status[row] = internStatus(status);
+}
+
+void ItemStore::removeAt(qsizetype row)
+{
+    m_ids.removeAt(row);
+    m_names.removeAt(row);
+    m_status.removeAt(row);
+}
+
+void ItemStore::truncate(qsizetype rows)
+{
+    if (rows >= size()) return;
+    m_ids.truncate(rows);
+    m_names.truncate(rows);
+    m_status.resize(rows);
+}
+
+qsizetype ItemStore::indexOfId(QStringView id) const
+{
+    const qsizetype n = size();
+    for (qsizetype i = 0; i < n; ++i) {
+        if (m_ids.lengths.at(i) == quint32(id.size()) && m_ids.view(i) == id)
+            return i;
+    }
+    return -1;
+}
+
+Item ItemStore::at(qsizetype row) const
+{
+    Item item;
+    item.id = id(row);
+    item.name = name(row);
+    item.status = status(row);
+    return item;
+}
+
+ItemStore::StatusCode ItemStore::internStatus(QStringView status)
+{
+    // The dictionary holds a handful of values; a linear probe beats hashing
+    for (qsizetype i = 0; i < m_statusNames.size(); ++i) {
+        if (m_statusNames.at(i) == status)
+            return StatusCode(i);
+    }
+    m_statusNames.append(status.toString());
+    return StatusCode(m_statusNames.size() - 1);
+}
+
+QList<int> ItemStore::countByStatus() const
+{
+    QList<int> counts(m_statusNames.size(), 0);
+    for (StatusCode code : m_status)
+        ++counts[code];
+    return counts;
+}
+
+qsizetype ItemStore::memoryUsage() const
+{
+    qsizetype bytes = m_ids.memoryUsage() + m_names.memoryUsage();
+    bytes += m_status.capacity() * qsizetype(sizeof(StatusCode));
+    for (const QString& s : m_statusNames)
+        bytes += qsizetype(sizeof(QString)) + s.capacity() * qsizetype(sizeof(QChar));
+    return bytes;
+}
+
+void ItemStore::StringColumn::clear()
+{
+    chars.clear();
+    offsets.clear();
+    lengths.clear();
+    garbage = 0;
+}
+
+void ItemStore::StringColumn::reserve(qsizetype rows, qsizetype totalChars)
+{
+    chars.reserve(totalChars);
+    offsets.reserve(rows);
+    lengths.reserve(rows);
+}
+
+quint32 ItemStore::StringColumn::push(QStringView s)
+{
+    const quint32 offset = quint32(chars.size());
+    chars.resize(chars.size() + s.size());
+    std::copy(s.utf16(), s.utf16() + s.size(), chars.data() + offset);
+    return offset;
+}
+
+void ItemStore::StringColumn::append(QStringView s)
+{
+    offsets.append(push(s));
+    lengths.append(quint32(s.size()));
+}
+
+void ItemStore::StringColumn::replace(qsizetype row, QStringView s)
+{
+    const quint32 oldLen = lengths.at(row);
+
+    if (quint32(s.size()) <= oldLen) {
+        // Fits in the existing slot: overwrite in place
+        std::copy(s.utf16(), s.utf16() + s.size(), chars.data() + offsets.at(row));
+        garbage += oldLen - quint32(s.size());
+    } else {
+        offsets[row] = push(s);
+        garbage += oldLen;
+    }
+    lengths[row] = quint32(s.size());
+    maybeCompact();
+}
+
+void ItemStore::StringColumn::removeAt(qsizetype row)
+{
+    garbage += lengths.at(row);
+    offsets.removeAt(row);
+    lengths.removeAt(row);
+    maybeCompact();
+}
+
+void ItemStore::StringColumn::truncate(qsizetype rows)
+{
+    if (rows == 0) {
+        clear();
+        return;
+    }
+    for (qsizetype i = rows; i < lengths.size(); ++i)
+        garbage += lengths.at(i);
+    offsets.resize(rows);
+    lengths.resize(rows);
+    maybeCompact();
+}
+
+void ItemStore::StringColumn::maybeCompact()
+{
+    if (garbage > 4096 && garbage * 2 > chars.size())
+        compact();
+}
+
+void ItemStore::StringColumn::compact()
+{
+    QList<char16_t> packed;
+    packed.reserve(chars.size() - garbage);
+    for (qsizetype i = 0; i < offsets.size(); ++i) {
+        const quint32 offset = quint32(packed.size());
+        const char16_t* src = chars.constData() + offsets.at(i);
+        packed.resize(packed.size() + lengths.at(i));
+        std::copy(src, src + lengths.at(i), packed.data() + offset);
+        offsets[i] = offset;
+    }
+    chars = std::move(packed);
+    garbage = 0;
+}
+
+qsizetype ItemStore::StringColumn::memoryUsage() const
+{
+    return chars.capacity() * qsizetype(sizeof(char16_t))
+         + offsets.capacity() * qsizetype(sizeof(quint32))
+         + lengths.capacity() * qsizetype(sizeof(quint32));
+}
@@ -0,0 +1,93 @@
+#ifndef ITEMSTORE_H
+#define ITEMSTORE_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include "Item.h"
+
+// Column-oriented container for Items.
+//
+// Each field lives in its own contiguous column instead of one QString triple
+// per row: `id` and `name` are packed into shared UTF-16 pools addressed by
+// offset/length, `status` is interned into a small per-store dictionary and
+// kept as a 16-bit code. Scans (indexOfId, per-status counting) walk flat
+// arrays and the per-row overhead drops from three QString headers + three
+// heap blocks to a handful of integers.
+class ItemStore
+{
+public:
+    using StatusCode = quint16;
+
+    qsizetype size() const { return m_status.size(); }
+    bool isEmpty() const { return m_status.isEmpty(); }
+
+    void clear();
+    void reserve(qsizetype rows, qsizetype charsPerRow = 16);
+
+    void append(const Item& item);
+    void append(QStringView id, QStringView name, QStringView status);
+    void replace(qsizetype row, const Item& item);
+    void replace(qsizetype row, QStringView id, QStringView name, QStringView status);
+    void removeAt(qsizetype row);
+    void truncate(qsizetype rows);
+
+    qsizetype indexOfId(QStringView id) const;
+
+    Item at(qsizetype row) const;
+
+    QStringView idView(qsizetype row) const { return m_ids.view(row); }
+    QStringView nameView(qsizetype row) const { return m_names.view(row); }
+    QString id(qsizetype row) const { return m_ids.view(row).toString(); }
+    QString name(qsizetype row) const { return m_names.view(row).toString(); }
+
+    StatusCode statusCode(qsizetype row) const { return m_status.at(row); }
+    QString status(qsizetype row) const { return m_statusNames.at(m_status.at(row)); }
+    QStringView statusView(qsizetype row) const { return m_statusNames.at(m_status.at(row)); }
+
+    // Interned status dictionary; codes are stable for the lifetime of the store.
+    const QStringList& statusNames() const { return m_statusNames; }
+    StatusCode internStatus(QStringView status);
+
+    // Number of rows per status code, indexed like statusNames().
+    QList<int> countByStatus() const;
+
+    // Approximate heap bytes held by the columns.
+    qsizetype memoryUsage() const;
+
+private:
+    // UTF-16 pool addressed by (offset, length). Replaced or removed strings
+    // leave holes that are reclaimed by compact() once they dominate the pool.
+    struct StringColumn {
+        QList<char16_t> chars;
+        QList<quint32>  offsets;
+        QList<quint32>  lengths;
+        qsizetype       garbage = 0;
+
+        QStringView view(qsizetype row) const
+        {
+            return QStringView(chars.constData() + offsets.at(row), lengths.at(row));
+        }
+
+        void clear();
+        void reserve(qsizetype rows, qsizetype totalChars);
+        void append(QStringView s);
+        void replace(qsizetype row, QStringView s);
+        void removeAt(qsizetype row);
+        void truncate(qsizetype rows);
+        void compact();
+        qsizetype memoryUsage() const;
+
+    private:
+        quint32 push(QStringView s);
+        void maybeCompact();
+    };
+
+    StringColumn       m_ids;
+    StringColumn       m_names;
+    QList<StatusCode>  m_status;
+    QStringList        m_statusNames;
+};
+
+#endif // ITEMSTORE_H
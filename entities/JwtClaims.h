@@ -0,0 +1,52 @@
+#ifndef JWTCLAIMS_H
+#define JWTCLAIMS_H
+
+#include <QString>
+#include <QStringList>
+#include "entities/UserSession.h"
+#include "serialization/JsonCodec.h"
+
+// Payload of an access token as issued by the PoC auth server
+struct JwtClaims
+{
+    QString subject;
+    QString username;
+    QString displayName;
+    QString email;
+    QStringList roles;
+    QStringList permissions;
+    qint64 issuedAt = 0;
+    qint64 notBefore = 0;
+    qint64 expiresAt = 0;
+
+    bool isValid() const { return !subject.isEmpty() && expiresAt > 0; }
+
+    UserSession toSession() const
+    {
+        UserSession session;
+        session.userId = subject;
+        session.username = username;
+        session.displayName = displayName;
+        session.email = email;
+        session.roles = roles;
+        session.permissions = permissions;
+        return session;
+    }
+};
+
+template<>
+struct JsonCodec::Fields<JwtClaims> {
+    static constexpr auto list = std::tuple{
+        JsonCodec::field("sub",                &JwtClaims::subject, JsonCodec::NumberAsString),
+        JsonCodec::field("preferred_username", &JwtClaims::username),
+        JsonCodec::field("name",               &JwtClaims::displayName),
+        JsonCodec::field("email",              &JwtClaims::email),
+        JsonCodec::field("roles",              &JwtClaims::roles),
+        JsonCodec::field("permissions",        &JwtClaims::permissions),
+        JsonCodec::field("iat",                &JwtClaims::issuedAt),
+        JsonCodec::field("nbf",                &JwtClaims::notBefore),
+        JsonCodec::field("exp",                &JwtClaims::expiresAt),
+    };
+};
+
+#endif // JWTCLAIMS_H
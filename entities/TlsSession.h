@@ -0,0 +1,24 @@
+#ifndef TLSSESSION_H
+#define TLSSESSION_H
+
+#include <QString>
+#include "serialization/JsonCodec.h"
+
+// A resumable TLS session as persisted: the ASN.1 session (ticket) Qt
+// reports after a handshake with `peer`
+struct TlsSession {
+    QString peer;        // "host:port"
+    QString ticket;      // base64
+    qint64 expiresAt = 0;
+};
+
+template<>
+struct JsonCodec::Fields<TlsSession> {
+    static constexpr auto list = std::tuple{
+        JsonCodec::field("peer",      &TlsSession::peer),
+        JsonCodec::field("ticket",    &TlsSession::ticket),
+        JsonCodec::field("expiresAt", &TlsSession::expiresAt),
+    };
+};
+
+#endif // TLSSESSION_H
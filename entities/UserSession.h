@@ -3,14 +3,10 @@
 
 #include <QString>
 #include <QStringList>
-#include <QDateTime>
-#include <QJsonObject>
-#include <QJsonArray>
-#include "IPersistable.h"
+#include "serialization/JsonCodec.h"
 
-class UserSession : public IPersistable
+struct UserSession
 {
-public:
     QString userId;
     QString username;
     QString displayName;
@@ -29,34 +25,18 @@ public:
         roles.clear();
         permissions.clear();
     }
+};
 
-    QJsonObject toJson() const override
-    {
-        QJsonObject obj;
-        obj["id"] = userId;
-        obj["username"] = username;
-        obj["displayName"] = displayName;
-        obj["email"] = email;
-        obj["roles"] = QJsonArray::fromStringList(roles);
-        obj["permissions"] = QJsonArray::fromStringList(permissions);
-        return obj;
-    }
-
-    void fromJson(const QJsonObject& obj) override
-    {
-        userId = obj["id"].toString();
-        username = obj["username"].toString();
-        displayName = obj["displayName"].toString();
-        email = obj["email"].toString();
-
-        roles.clear();
-        for (const auto& v : obj["roles"].toArray())
-            if (v.isString()) roles.append(v.toString());
-
-        permissions.clear();
-        for (const auto& v : obj["permissions"].toArray())
-            if (v.isString()) permissions.append(v.toString());
-    }
+template<>
+struct JsonCodec::Fields<UserSession> {
+    static constexpr auto list = std::tuple{
+        JsonCodec::field("id",          &UserSession::userId),
+        JsonCodec::field("username",    &UserSession::username),
+        JsonCodec::field("displayName", &UserSession::displayName),
+        JsonCodec::field("email",       &UserSession::email),
+        JsonCodec::field("roles",       &UserSession::roles),
+        JsonCodec::field("permissions", &UserSession::permissions),
+    };
 };
 
 #endif // USERSESSION_H
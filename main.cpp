@@ -1,23 +1,30 @@
 #include <QGuiApplication>
+#include <QLoggingCategory>
 #include <QQmlApplicationEngine>
+#include <QQuickWindow>
+#include <memory>
 
 #include "config.h"
+#include "ConfigWatcher.h"
 #include "networking/ApiEndpoints.h"
 #include "networking/HttpClient.h"
 #include "networking/AuthApi.h"
 #include "networking/ItemApi.h"
+#include "networking/RateLimiter.h"
+#include "networking/TlsSessionCache.h"
 #include "auth/AuthManager.h"
 #include "auth/PermissionManager.h"
 #include "auth/SecureTokenStorage.h"
 #include "models/ItemModel.h"
+#include "startup/StartupPipeline.h"
+#include "startup/StartupTrace.h"
 
 int main(int argc, char *argv[])
 {
-    QGuiApplication app(argc, argv);
+    StartupTrace trace;
 
-    ensureUserConfigExists();
-    AppConfig appConfig = loadConfig();
-    ApiEndpoints::BaseUrl = appConfig.restBaseUrl;
+    QGuiApplication app(argc, argv);
+    trace.mark("application");
 
     QCoreApplication::setOrganizationName("IRIDESS");
     QCoreApplication::setApplicationName("PoCAuthSystem");
@@ -36,25 +43,130 @@ int main(int argc, char *argv[])
 
     auto* authHttpClient = new HttpClient(&app);
     auto* authApi        = new AuthApi(authHttpClient, &app);
-    auto* tokenStorage   = new SecureTokenStorage(&app);
 
     auto* itemHttpClient = new HttpClient(&app);
     auto* itemApi        = new ItemApi(itemHttpClient, &app);
 
+    // Created after the clients so they outlive them. Both
+    // clients talk to the same backend: a 429 pauses either.
+    auto* tlsSessions = new TlsSessionCache(&app);
+    auto* rateLimiter = new RateLimiter(&app);
+    for (HttpClient* client : { authHttpClient, itemHttpClient }) {
+        client->setTlsSessionCache(tlsSessions);
+        client->setRateLimiter(rateLimiter);
+    }
+
     auto* authManager = engine.singletonInstance<AuthManager*>("PoCAuthSystem", "AuthManager");
     auto* permManager = engine.singletonInstance<PermissionManager*>("PoCAuthSystem", "PermissionManager");
     auto* itemModel   = engine.singletonInstance<ItemModel*>("PoCAuthSystem", "ItemModel");
 
-    authManager->initialize(authApi, tokenStorage, permManager);
     itemModel->initialize(itemApi);
 
     QObject::connect(authManager, &AuthManager::tokenChanged, itemHttpClient, &HttpClient::setBearerToken);
+    itemHttpClient->setTokenRefresher([authManager](std::function<void(bool)> done) {
+        authManager->refreshSession(std::move(done));
+    });
     QObject::connect(authManager, &AuthManager::loginSucceeded, itemModel, &ItemModel::fetch);
     QObject::connect(authManager, &AuthManager::loggedOut, itemHttpClient, &HttpClient::clearBearerToken);
 
-    authManager->tryAutoLogin();
+    // Disk reads run on workers while the main thread loads QML; their
+    // results are handed to the main-thread tasks that depend on them.
+    struct Loaded {
+        AppConfig config;
+        SecureTokenStorage::Contents tokens;
+    };
+    auto loaded = std::make_shared<Loaded>();
+    const QString tokenPath = SecureTokenStorage::defaultPath();
+
+    // The trace is reported once the pipeline is done and a frame is shown
+    auto reportWhenInteractive = [&trace, pending = std::make_shared<int>(2)]() {
+        if (--*pending == 0) trace.report();
+    };
+
+    StartupPipeline pipeline(trace);
+
+    pipeline.add("config", {}, StartupPipeline::Background, [loaded]() {
+        ensureUserConfigExists();
+        loaded->config = loadConfig();
+    });
+
+    pipeline.add("token-store", {}, StartupPipeline::Background, [loaded, tokenPath]() {
+        loaded->tokens = SecureTokenStorage::read(tokenPath);
+    });
+
+    pipeline.add("qml", {}, StartupPipeline::MainThread, [&]() {
+        engine.loadFromModule("PoCAuthSystem", "Main");
+        auto* window = qobject_cast<QQuickWindow*>(engine.rootObjects().value(0));
+        if (!window) return;
+
+        // Rendered on the scene graph thread; the mark is queued to the main thread
+        QObject::connect(window, &QQuickWindow::frameSwapped, &app, [&trace, reportWhenInteractive]() {
+            trace.mark("first frame");
+            reportWhenInteractive();
+        }, Qt::SingleShotConnection);
+    });
+
+    // Applied at startup and again whenever config.ini changes on disk
+    const auto applyConfig = [=](const AppConfig& config) {
+        QLoggingCategory::setFilterRules(config.logRules);
+
+        ApiEndpoints::BaseUrl = config.restBaseUrl;
+        if (!config.tlsCaFile.isEmpty())
+            HttpClient::addCaCertificates(config.tlsCaFile);
+        for (HttpClient* client : { authHttpClient, itemHttpClient }) {
+            client->setNetworkThreadEnabled(config.networkThread);
+            client->setTransferTimeout(config.transferTimeoutMs);
+            client->setDefaultRetryPolicy(config.retry);
+            client->setKeepWarm(config.warmUp ? QUrl(config.restBaseUrl) : QUrl(), config.keepWarmSec);
+        }
+
+        rateLimiter->setLimits(config.rateLimit, config.rateBurst);
+
+        authManager->setTokenVerificationKey(config.jwtKey);
+        authManager->setRefreshMargin(config.refreshMarginSec);
+        permManager->setRoleDefinitions(config.roles);
+    };
+
+    pipeline.add("config-apply", { "config" }, StartupPipeline::MainThread, [&app, loaded, applyConfig]() {
+        applyConfig(loaded->config);
+
+        auto* watcher = new ConfigWatcher(loaded->config, &app);
+        QObject::connect(watcher, &ConfigWatcher::changed, &app, [applyConfig](const AppConfig& config) {
+            applyConfig(config);
+            qDebug().noquote() << "[Config] Applied";
+        });
+    });
+
+    // Before the warm-up, so its handshake already resumes
+    pipeline.add("tls-sessions", { "token-store" }, StartupPipeline::MainThread, [loaded, tlsSessions]() {
+        tlsSessions->restore(loaded->tokens.tlsSessions);
+    });
+
+    pipeline.add("network-warmup", { "config-apply", "tls-sessions" }, StartupPipeline::MainThread,
+                 [loaded, authHttpClient, itemHttpClient]() {
+        if (!loaded->config.warmUp) return;
+        const QUrl baseUrl(loaded->config.restBaseUrl);
+        authHttpClient->warmUp(baseUrl);
+        itemHttpClient->warmUp(baseUrl);
+    });
+
+    pipeline.add("auto-login", { "config-apply", "tls-sessions" }, StartupPipeline::MainThread,
+                 [&app, loaded, authApi, authManager, permManager, tlsSessions]() {
+        auto* tokenStorage = new SecureTokenStorage(std::move(loaded->tokens), &app);
+        // Emitted on the I/O threads; saved on this one
+        QObject::connect(tlsSessions, &TlsSessionCache::changed, tokenStorage, [tlsSessions, tokenStorage]() {
+            tokenStorage->saveTlsSessions(tlsSessions->sessions());
+        });
+        authManager->initialize(authApi, tokenStorage, permManager);
+        authManager->tryAutoLogin();
+    });
+
+    QObject::connect(&pipeline, &StartupPipeline::finished, &app, [&trace, reportWhenInteractive]() {
+        trace.mark("pipeline done");
+        reportWhenInteractive();
+    });
 
-    engine.loadFromModule("PoCAuthSystem", "Main");
+    pipeline.start();
 
     return app.exec();
 }
@@ -0,0 +1,100 @@
+#include "GroupCountModel.h"
+
+GroupCountModel::GroupCountModel(QObject* parent)
+    : QAbstractListModel(parent) {}
+
+int GroupCountModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) return 0;
+    return int(m_labels.size());
+}
+
+QVariant GroupCountModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid()) return {};
+    if (index.row() < 0 || index.row() >= m_labels.size()) return {};
+
+    switch (role) {
+    case KeyRole:   return m_labels.at(index.row());
+    case CountRole: return m_counts.at(index.row());
+    }
+    return {};
+}
+
+QHash<int, QByteArray> GroupCountModel::roleNames() const
+{
+    return {
+        { KeyRole,   "key"   },
+        { CountRole, "count" },
+    };
+}
+
+int GroupCountModel::countFor(const QString& key) const
+{
+    const qsizetype row = m_labels.indexOf(key);
+    return row < 0 ? 0 : m_counts.at(row);
+}
+
+void GroupCountModel::add(int code, const QString& label, int delta)
+{
+    if (delta == 0) return;
+
+    const int row = rowForCode(code, label);
+    m_counts[row] += delta;
+
+    const QModelIndex idx = index(row);
+    emit dataChanged(idx, idx, { CountRole });
+    setTotal(m_total + delta);
+}
+
+void GroupCountModel::reset(const QStringList& labels, const QList<int>& counts)
+{
+    // Codes belong to the previous store; rebind them by label. Rows are kept
+    // (at zero) when a group disappears so QML delegates are not recreated.
+    m_rowForCode.clear();
+    for (qsizetype code = 0; code < labels.size(); ++code)
+        rowForCode(int(code), labels.at(code));
+
+    QList<int> next(m_counts.size(), 0);
+    int total = 0;
+    for (qsizetype code = 0; code < labels.size(); ++code) {
+        const int n = code < counts.size() ? counts.at(code) : 0;
+        next[m_rowForCode.at(code)] = n;
+        total += n;
+    }
+
+    for (qsizetype row = 0; row < m_counts.size(); ++row) {
+        if (m_counts.at(row) == next.at(row)) continue;
+        m_counts[row] = next.at(row);
+        const QModelIndex idx = index(int(row));
+        emit dataChanged(idx, idx, { CountRole });
+    }
+    setTotal(total);
+}
+
+int GroupCountModel::rowForCode(int code, const QString& label)
+{
+    if (code < m_rowForCode.size() && m_rowForCode.at(code) >= 0)
+        return m_rowForCode.at(code);
+
+    int row = int(m_labels.indexOf(label));
+    if (row < 0) {
+        row = int(m_labels.size());
+        beginInsertRows({}, row, row);
+        m_labels.append(label);
+        m_counts.append(0);
+        endInsertRows();
+    }
+
+    if (code >= m_rowForCode.size())
+        m_rowForCode.resize(code + 1, -1);
+    m_rowForCode[code] = row;
+    return row;
+}
+
+void GroupCountModel::setTotal(int total)
+{
+    if (m_total == total) return;
+    m_total = total;
+    emit totalChanged();
+}
@@ -0,0 +1,56 @@
+#ifndef GROUPCOUNTMODEL_H
+#define GROUPCOUNTMODEL_H
+
+#include <QAbstractListModel>
+#include <QList>
+#include <QStringList>
+#include <QQmlEngine>
+
+// Per-group counters exposed to QML as a list model (key, count).
+//
+// Groups are addressed by a small integer code chosen by the owner (e.g. an
+// ItemStore status code) plus its label. add() is O(1) and notifies only the
+// row that changed; reset() rebinds codes after a bulk load and notifies only
+// the groups whose count actually differs.
+class GroupCountModel : public QAbstractListModel
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Owned by ItemModel.")
+
+    Q_PROPERTY(int total READ total NOTIFY totalChanged FINAL)
+
+public:
+    explicit GroupCountModel(QObject* parent = nullptr);
+
+    enum Roles {
+        KeyRole   = Qt::UserRole + 1,
+        CountRole,
+    };
+    Q_ENUM(Roles)
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    Q_INVOKABLE int countFor(const QString& key) const;
+
+    void add(int code, const QString& label, int delta);
+    void reset(const QStringList& labels, const QList<int>& counts);
+
+    int total() const { return m_total; }
+
+signals:
+    void totalChanged();
+
+private:
+    int rowForCode(int code, const QString& label);
+    void setTotal(int total);
+
+    QStringList m_labels;
+    QList<int>  m_counts;
+    QList<int>  m_rowForCode;
+    int         m_total = 0;
+};
+
+#endif // GROUPCOUNTMODEL_H
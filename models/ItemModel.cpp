@@ -1,9 +1,31 @@
 #include "ItemModel.h"
 #include "networking/ItemApi.h"
+#include "networking/ItemImport.h"
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QSaveFile>
+#include <QUrl>
+
+namespace {
+// Rows per begin/endInsertRows burst inside a slice; the budget is
+// re-checked between chunks.
+constexpr qsizetype kApplyChunk = 256;
+
+// QML file dialogs hand over URLs
+QString localPath(const QString& pathOrUrl)
+{
+    const QUrl url(pathOrUrl);
+    return url.isLocalFile() ? url.toLocalFile() : pathOrUrl;
+}
+}
 
 ItemModel::ItemModel(QObject* parent)
-    : QAbstractListModel(parent) {}
+    : QAbstractListModel(parent)
+    , m_statusCounts(this)
+{
+    m_applyTimer.setInterval(0);
+    connect(&m_applyTimer, &QTimer::timeout, this, &ItemModel::applySlice);
+}
 
 void ItemModel::initialize(ItemApi* api)
 {
@@ -13,19 +35,19 @@ void ItemModel::initialize(ItemApi* api)
 int ItemModel::rowCount(const QModelIndex& parent) const
 {
     if (parent.isValid()) return 0;
-    return m_items.size();
+    return int(m_visibleRows);
 }
 
 QVariant ItemModel::data(const QModelIndex& index, int role) const
 {
     if (!index.isValid()) return {};
-    if (index.row() < 0 || index.row() >= m_items.size()) return {};
+    if (index.row() < 0 || index.row() >= m_visibleRows) return {};
 
-    const auto& item = m_items[index.row()];
+    const int row = index.row();
     switch (role) {
-    case IdRole:     return item.id;
-    case NameRole:   return item.name;
-    case StatusRole: return item.status;
+    case IdRole:     return m_store.id(row);
+    case NameRole:   return m_store.name(row);
+    case StatusRole: return m_store.status(row);
     }
     return {};
 }
@@ -46,16 +68,12 @@ void ItemModel::fetch()
     setLoading(true);
     setError({});
 
-    m_api->fetchAll([this](const QList<Item>& items) {
-        beginResetModel();
-        m_items = QVector<Item>(items.begin(), items.end());
-        endResetModel();
-        setLoading(false);
-        qDebug().noquote() << "[ItemModel] fetch → loaded" << m_items.size() << "items";
-        emit fetched();
+    m_api->fetchAll([this](ItemStore&& batch) {
+        qDebug().noquote() << "[ItemModel] fetch → received" << batch.size() << "items";
+        applyBatch(std::move(batch));
     }, [this](const ErrorResult& err) {
         qWarning().noquote() << "[ItemModel] fetch → error:" << err.message;
-        setLoading(false);
+        setLoading(applying());
         setError(err.message);
     });
 }
@@ -67,18 +85,16 @@ void ItemModel::create(const QString& name, const QString& status)
     setLoading(true);
     setError({});
 
-    m_api->create(name, status, [this](const Item& item) {
-        const int row = m_items.size();
-        beginInsertRows({}, row, row);
-        m_items.append(item);
-        endInsertRows();
-        setLoading(false);
-        qDebug().noquote() << "[ItemModel] create → success  id=" << item.id
-                           << "row=" << row;
+    m_api->create(name, status, [this](Item&& item) {
+        const QString id = item.id;
+        qDebug().noquote() << "[ItemModel] create → success  id=" << id;
+        if (applying()) defer(id, DeferredEdit::Kind::Create, std::move(item));
+        else insertItem(item);
+        setLoading(applying());
         emit created();
     }, [this](const ErrorResult& err) {
         qWarning().noquote() << "[ItemModel] create → error:" << err.message;
-        setLoading(false);
+        setLoading(applying());
         setError(err.message);
     });
 }
@@ -90,22 +106,14 @@ void ItemModel::update(const QString& id, const QString& name)
     setLoading(true);
     setError({});
 
-    m_api->update(id, name, [this, id](const Item& updated) {
-        for (int i = 0; i < m_items.size(); ++i) {
-            if (m_items[i].id == id) {
-                m_items[i] = updated;
-                const QModelIndex idx = index(i);
-                emit dataChanged(idx, idx);
-                qDebug().noquote() << "[ItemModel] update → success  id=" << id
-                                   << "row=" << i;
-                break;
-            }
-        }
-        setLoading(false);
+    m_api->update(id, name, [this, id](Item&& updated) {
+        if (applying()) defer(id, DeferredEdit::Kind::Update, std::move(updated));
+        else updateItem(id, updated);
+        setLoading(applying());
         emit this->updated();
     }, [this](const ErrorResult& err) {
         qWarning().noquote() << "[ItemModel] update → error:" << err.message;
-        setLoading(false);
+        setLoading(applying());
         setError(err.message);
     });
 }
@@ -118,27 +126,221 @@ void ItemModel::remove(const QString& id)
     setError({});
 
     m_api->remove(id, [this, id]() {
-        for (int i = 0; i < m_items.size(); ++i) {
-            if (m_items[i].id == id) {
-                beginRemoveRows({}, i, i);
-                m_items.removeAt(i);
-                endRemoveRows();
-                qDebug().noquote() << "[ItemModel] remove → success  id=" << id
-                                   << "row=" << i;
-                break;
-            }
-        }
-        setLoading(false);
+        if (applying()) defer(id, DeferredEdit::Kind::Remove);
+        else removeItem(id);
+        setLoading(applying());
         emit removed();
     }, [this](const ErrorResult& err) {
         qWarning().noquote() << "[ItemModel] remove → error:" << err.message;
-        setLoading(false);
+        setLoading(applying());
+        setError(err.message);
+    });
+}
+
+void ItemModel::exportItems(const QString& path)
+{
+    if (!m_api) return;
+    qDebug().noquote() << "[ItemModel] exportItems()" << path;
+
+    // Written to a temporary file and only moved over `path` when complete
+    auto* file = new QSaveFile(localPath(path), this);
+    if (!file->open(QIODevice::WriteOnly)) {
+        setError("Cannot write " + file->fileName() + ": " + file->errorString());
+        delete file;
+        return;
+    }
+    setLoading(true);
+    setError({});
+
+    m_api->exportTo(file, [this, file](qint64 count) {
+        if (file->commit()) {
+            qDebug().noquote() << "[ItemModel] export → wrote" << count << "items";
+            emit exported(int(count));
+        } else {
+            setError("Cannot write " + file->fileName() + ": " + file->errorString());
+        }
+        file->deleteLater();
+        setLoading(applying());
+    }, [this, file](const ErrorResult& err) {
+        qWarning().noquote() << "[ItemModel] export → error:" << err.message;
+        file->cancelWriting();
+        file->deleteLater();
+        setLoading(applying());
         setError(err.message);
     });
 }
 
+void ItemModel::importItems(const QString& path)
+{
+    if (!m_api) return;
+    if (m_import) {
+        setError("An import is already running");
+        return;
+    }
+    qDebug().noquote() << "[ItemModel] importItems()" << path;
+    setLoading(true);
+    setError({});
+
+    m_import = new ItemImport(m_api, localPath(path), {}, this);
+    connect(m_import, &ItemImport::finished, this, [this](qint64 count, qint64 rejected) {
+        qDebug().noquote() << "[ItemModel] import → created" << count << "items," << rejected << "rejected";
+        m_import->deleteLater();
+        emit imported(int(count), int(rejected));
+        fetch();
+    });
+    connect(m_import, &ItemImport::failed, this, [this](const QString& message) {
+        qWarning().noquote() << "[ItemModel] import → error:" << message;
+        m_import->deleteLater();
+        setLoading(applying());
+        setError(message);
+    });
+    m_import->start();
+}
+
+void ItemModel::cancelImport()
+{
+    if (m_import) m_import->cancel();
+}
+
+void ItemModel::applyBatch(ItemStore&& batch)
+{
+    // The batch becomes the backing store as is; its pools are never copied.
+    // Rows already visible are refreshed in place and the rest are revealed
+    // slice by slice. A newer batch simply supersedes one still revealing.
+    const qsizetype keep = qMin(m_visibleRows, batch.size());
+    if (m_visibleRows > keep) {
+        beginRemoveRows({}, int(keep), int(m_visibleRows - 1));
+        m_visibleRows = keep;
+        endRemoveRows();
+    }
+
+    m_store = std::move(batch);
+    if (keep > 0)
+        emit dataChanged(index(0), index(int(keep - 1)));
+    m_statusCounts.reset(m_store.statusNames(), m_store.countByStatus());
+
+    setProgress(m_store.isEmpty() ? 1.0 : qreal(keep) / qreal(m_store.size()));
+    setLoading(true);
+
+    applySlice();
+    if (m_visibleRows < m_store.size() && !m_applyTimer.isActive())
+        m_applyTimer.start();
+}
+
+void ItemModel::applySlice()
+{
+    QElapsedTimer clock;
+    clock.start();
+    const qint64 budgetNs = qint64(m_frameBudgetMs) * 1000000;
+    const qsizetype total = m_store.size();
+
+    while (m_visibleRows < total && clock.nsecsElapsed() < budgetNs) {
+        const qsizetype first = m_visibleRows;
+        const qsizetype last = qMin(total, first + kApplyChunk) - 1;
+        beginInsertRows({}, int(first), int(last));
+        m_visibleRows = last + 1;
+        endInsertRows();
+    }
+
+    if (m_visibleRows < total) {
+        setProgress(qreal(m_visibleRows) / qreal(total));
+        return;
+    }
+
+    finishApply();
+}
+
+void ItemModel::finishApply()
+{
+    m_applyTimer.stop();
+
+    for (const QString& id : std::as_const(m_deferredOrder)) {
+        const DeferredEdit& edit = m_deferred[id];
+        switch (edit.kind) {
+        case DeferredEdit::Kind::Create:
+            if (m_store.indexOfId(id) >= 0) updateItem(id, edit.item);
+            else insertItem(edit.item);
+            break;
+        case DeferredEdit::Kind::Update:
+            // Like outside an apply: a row gone from the batch stays gone
+            updateItem(id, edit.item);
+            break;
+        case DeferredEdit::Kind::Remove:
+            removeItem(id);
+            break;
+        }
+    }
+    m_deferred.clear();
+    m_deferredOrder.clear();
+
+    setProgress(1.0);
+    setLoading(false);
+    qDebug().noquote() << "[ItemModel] fetch → loaded" << m_store.size() << "items"
+                       << "(" << m_store.memoryUsage() << "bytes )";
+    emit fetched();
+}
+
+void ItemModel::defer(const QString& id, DeferredEdit::Kind kind, Item item)
+{
+    // Later edits to the same row replace earlier ones, but a created row
+    // edited again is still inserted
+    const auto it = m_deferred.find(id);
+    if (it == m_deferred.end()) {
+        m_deferredOrder.append(id);
+        m_deferred.insert(id, DeferredEdit{ kind, std::move(item) });
+        return;
+    }
+    if (it->kind == DeferredEdit::Kind::Create && kind == DeferredEdit::Kind::Update)
+        kind = DeferredEdit::Kind::Create;
+    *it = DeferredEdit{ kind, std::move(item) };
+}
+
+void ItemModel::insertItem(const Item& item)
+{
+    const int row = int(m_store.size());
+    beginInsertRows({}, row, row);
+    m_store.append(item);
+    m_visibleRows = m_store.size();
+    endInsertRows();
+    countStatus(m_store.statusCode(row), +1);
+    qDebug().noquote() << "[ItemModel] insert id=" << item.id << "row=" << row;
+}
+
+void ItemModel::updateItem(const QString& id, const Item& item)
+{
+    const int i = int(m_store.indexOfId(id));
+    if (i < 0) return;
+
+    const ItemStore::StatusCode before = m_store.statusCode(i);
+    m_store.replace(i, item);
+    const QModelIndex idx = index(i);
+    emit dataChanged(idx, idx);
+    if (m_store.statusCode(i) != before) {
+        countStatus(before, -1);
+        countStatus(m_store.statusCode(i), +1);
+    }
+    qDebug().noquote() << "[ItemModel] update id=" << id << "row=" << i;
+}
+
+void ItemModel::removeItem(const QString& id)
+{
+    const int i = int(m_store.indexOfId(id));
+    if (i < 0) return;
+
+    const ItemStore::StatusCode code = m_store.statusCode(i);
+    beginRemoveRows({}, i, i);
+    m_store.removeAt(i);
+    m_visibleRows = m_store.size();
+    endRemoveRows();
+    countStatus(code, -1);
+    qDebug().noquote() << "[ItemModel] remove id=" << id << "row=" << i;
+}
+
 bool ItemModel::loading() const { return m_loading; }
 QString ItemModel::error() const { return m_error; }
+qreal ItemModel::progress() const { return m_progress; }
+int ItemModel::frameBudgetMs() const { return m_frameBudgetMs; }
+GroupCountModel* ItemModel::statusCounts() { return &m_statusCounts; }
 
 void ItemModel::setLoading(bool value)
 {
@@ -147,9 +349,29 @@ void ItemModel::setLoading(bool value)
     emit loadingChanged();
 }
 
+void ItemModel::setFrameBudgetMs(int ms)
+{
+    ms = qMax(1, ms);
+    if (m_frameBudgetMs == ms) return;
+    m_frameBudgetMs = ms;
+    emit frameBudgetMsChanged();
+}
+
+void ItemModel::setProgress(qreal value)
+{
+    if (m_progress == value) return;
+    m_progress = value;
+    emit progressChanged();
+}
+
 void ItemModel::setError(const QString& message)
 {
     if (m_error == message) return;
     m_error = message;
     emit errorChanged();
 }
+
+void ItemModel::countStatus(ItemStore::StatusCode code, int delta)
+{
+    m_statusCounts.add(code, m_store.statusNames().at(code), delta);
+}
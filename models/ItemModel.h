@@ -2,11 +2,16 @@
 #define ITEMMODEL_H
 
 #include <QAbstractListModel>
-#include <QVector>
+#include <QHash>
+#include <QPointer>
 #include <QQmlEngine>
+#include <QTimer>
 #include "entities/Item.h"
+#include "entities/ItemStore.h"
+#include "GroupCountModel.h"
 
 class ItemApi;
+class ItemImport;
 
 class ItemModel : public QAbstractListModel
 {
@@ -17,6 +22,9 @@ class ItemModel : public QAbstractListModel
 
     Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged FINAL)
     Q_PROPERTY(QString error READ error NOTIFY errorChanged FINAL)
+    Q_PROPERTY(qreal progress READ progress NOTIFY progressChanged FINAL)
+    Q_PROPERTY(int frameBudgetMs READ frameBudgetMs WRITE setFrameBudgetMs NOTIFY frameBudgetMsChanged FINAL)
+    Q_PROPERTY(GroupCountModel* statusCounts READ statusCounts CONSTANT FINAL)
 
 public:
     explicit ItemModel(QObject* parent = nullptr);
@@ -39,25 +47,77 @@ public:
     Q_INVOKABLE void update(const QString& id, const QString& name);
     Q_INVOKABLE void remove(const QString& id);
 
+    // Newline-delimited JSON, one item per line. `path` may be a local
+    // file path or a file: URL. An import resumes from its checkpoint when
+    // the same file is imported again after an interruption, and the model
+    // is refetched once it is done.
+    Q_INVOKABLE void exportItems(const QString& path);
+    Q_INVOKABLE void importItems(const QString& path);
+    Q_INVOKABLE void cancelImport();
+
     bool loading() const;
     QString error() const;
+    qreal progress() const;
+    int frameBudgetMs() const;
+    void setFrameBudgetMs(int ms);
+    GroupCountModel* statusCounts();
 
 signals:
     void loadingChanged();
     void errorChanged();
+    void progressChanged();
+    void frameBudgetMsChanged();
     void fetched();
     void created();
     void updated();
     void removed();
+    void exported(int count);
+    void imported(int count, int rejected);
 
 private:
     void setLoading(bool value);
     void setError(const QString& message);
+    void setProgress(qreal value);
+    void countStatus(ItemStore::StatusCode code, int delta);
+
+    // A fetched batch is adopted by move as the backing store in one step;
+    // only the row insertions views see are spread over several event-loop
+    // iterations, each bounded by m_frameBudgetMs, so large results never
+    // stall a frame. Row edits that arrive meanwhile are coalesced per id
+    // and applied once every row is visible.
+    bool applying() const { return m_applyTimer.isActive(); }
+    void applyBatch(ItemStore&& batch);
+    void applySlice();
+    void finishApply();
+
+    // Row edit held back until the batch is fully revealed
+    struct DeferredEdit {
+        enum class Kind { Create, Update, Remove };
+        Kind kind;
+        Item item;   // unused for Remove
+    };
+    void defer(const QString& id, DeferredEdit::Kind kind, Item item = {});
+
+    void insertItem(const Item& item);
+    void updateItem(const QString& id, const Item& item);
+    void removeItem(const QString& id);
+
+    ItemApi*        m_api = nullptr;
+    QPointer<ItemImport> m_import;
+    ItemStore       m_store;
+    GroupCountModel m_statusCounts;
+    bool            m_loading = false;
+    QString         m_error;
+
+    // Rows of m_store announced to views; trails m_store.size() while a
+    // batch is being revealed
+    qsizetype       m_visibleRows = 0;
+    QTimer          m_applyTimer;
+    int             m_frameBudgetMs = 4;
+    qreal           m_progress = 1.0;
 
-    ItemApi*      m_api = nullptr;
-    QVector<Item> m_items;
-    bool          m_loading = false;
-    QString       m_error;
+    QHash<QString, DeferredEdit> m_deferred;
+    QStringList                  m_deferredOrder;
 };
 
 #endif // ITEMMODEL_H
@@ -1,9 +1,27 @@
 #include "AuthApi.h"
-#include <QJsonDocument>
-#include <QJsonObject>
 #include <QDebug>
 #include "ApiEndpoints.h"
 
+namespace {
+
+// Token fields sit at the top level next to the nested "user" object
+bool readLoginResult(JsonReader& r, LoginResult& result)
+{
+    if (!r.beginObject()) return false;
+
+    QByteArrayView key;
+    while (r.nextKey(key)) {
+        if (key == QByteArrayView("user")) {
+            if (!JsonCodec::readValue(r, result.user, JsonCodec::NoFlags)) return false;
+        } else if (!JsonCodec::readField(r, key, result.tokens) && !r.skipValue()) {
+            return false;
+        }
+    }
+    return !r.hasError();
+}
+
+} // namespace
+
 AuthApi::AuthApi(HttpClient* client, QObject* parent)
     : BaseApi(client, parent) {}
 
@@ -14,25 +32,23 @@ void AuthApi::login(const QString& username,
 {
     if (!ensureClient(errorCb)) return;
 
-    QJsonObject body;
-    body["username"] = username;
-    body["password"] = password;
+    QByteArray payload;
+    JsonWriter body(payload);
+    body.beginObject();
+    body.key("username");
+    body.string(username);
+    body.key("password");
+    body.string(password);
+    body.endObject();
 
-    client()->post(ApiEndpoints::AuthLogin(), QJsonDocument(body).toJson(QJsonDocument::Compact), [
+    client()->post(ApiEndpoints::AuthLogin(), payload, [
         successCb = std::move(successCb),
         errorCb = std::move(errorCb)
     ](QRestReply& reply) mutable {
-        expectObject(reply, errorCb, [&](const QJsonObject& obj) {
+        expectEntity<LoginResult>(reply, errorCb, [&](LoginResult&& result) {
             if (!successCb) return;
-
-            LoginResult result;
-            result.tokens.accessToken = obj["accessToken"].toString();
-            result.tokens.refreshToken = obj["refreshToken"].toString();
-            result.tokens.expiresIn = obj["expiresIn"].toInt();
-            result.user.fromJson(obj["user"].toObject());
-
             successCb(result);
-        });
+        }, &readLoginResult);
     });
 }
 
@@ -42,24 +58,21 @@ void AuthApi::refresh(const QString& refreshToken,
 {
     if (!ensureClient(errorCb)) return;
 
-    QJsonObject body;
-    body["refreshToken"] = refreshToken;
+    QByteArray payload;
+    JsonWriter body(payload);
+    body.beginObject();
+    body.key("refreshToken");
+    body.string(refreshToken);
+    body.endObject();
 
-    client()->post(ApiEndpoints::AuthRefresh(), QJsonDocument(body).toJson(QJsonDocument::Compact), [
+    client()->post(ApiEndpoints::AuthRefresh(), payload, [
         successCb = std::move(successCb),
         errorCb = std::move(errorCb)
     ](QRestReply& reply) mutable {
-        expectObject(reply, errorCb, [&](const QJsonObject& obj) {
+        expectEntity<LoginResult>(reply, errorCb, [&](LoginResult&& result) {
             if (!successCb) return;
-
-            LoginResult result;
-            result.tokens.accessToken = obj["accessToken"].toString();
-            result.tokens.refreshToken = obj["refreshToken"].toString();
-            result.tokens.expiresIn = obj["expiresIn"].toInt();
-            result.user.fromJson(obj["user"].toObject());
-
             successCb(result);
-        });
+        }, &readLoginResult);
     });
 }
 
@@ -6,10 +6,16 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QMetaObject>
+#include <QPointer>
 #include <QRestReply>
+#include <QThreadPool>
+#include <memory>
+#include <type_traits>
 
 #include "ApiTypes.h"
 #include "HttpClient.h"
+#include "serialization/JsonCodec.h"
 
 class BaseApi : public QObject
 {
@@ -97,6 +103,119 @@ protected:
         });
     }
 
+    // Decodes a single object body straight from the token stream into T,
+    // using T's field table unless a custom `decode` is given.
+    template<typename T, typename Fn>
+    requires std::invocable<Fn, T&&>
+    static void expectEntity(QRestReply& reply, ErrorCb& errorCb, Fn&& fn,
+                             bool (*decode)(JsonReader&, T&) = &JsonCodec::read<T>)
+    {
+        if (!reply.isSuccess()) {
+            emitError(errorCb, fromReply(reply));
+            return;
+        }
+
+        const QByteArray body = reply.readBody();
+        JsonReader reader(body);
+        const JsonReader::Token token = reader.peek();
+        if (token != JsonReader::ObjectBegin) {
+            emitError(errorCb, fromReply(reply, token == JsonReader::Invalid ? "Invalid JSON response"
+                                                                             : "Unexpected JSON type"));
+            return;
+        }
+
+        T value;
+        if (!decode(reader, value) || !reader.atEnd()) {
+            emitError(errorCb, fromReply(reply, "Invalid JSON response"));
+            return;
+        }
+        fn(std::move(value));
+    }
+
+    // Array counterpart of expectEntity that runs on the global thread pool.
+    // `decode` receives a reader positioned on the array and returns the
+    // decoded value, which is moved back to `context`'s thread and handed to
+    // `fn` there; errors are reported on the same thread. Nothing is
+    // delivered if `context` is destroyed in the meantime.
+    template<typename Decode, typename Fn>
+    requires std::invocable<Decode, JsonReader&>
+          && std::invocable<Fn, std::invoke_result_t<Decode, JsonReader&>&&>
+    static void expectArrayInBackground(QRestReply& reply, ErrorCb& errorCb, QObject* context,
+                                        Decode&& decode, Fn&& fn)
+    {
+        if (!reply.isSuccess()) {
+            emitError(errorCb, fromReply(reply));
+            return;
+        }
+
+        // Decoders and callbacks may be move-only; the pool gets a shared handle
+        QThreadPool::globalInstance()->start(shareCallable([
+            mailbox = Mailbox(context),
+            body = reply.readBody(),
+            invalid = fromReply(reply, "Invalid JSON response"),
+            unexpected = fromReply(reply, "Unexpected JSON type"),
+            errorCb,
+            decode = std::forward<Decode>(decode),
+            fn = std::forward<Fn>(fn)
+        ]() mutable {
+            JsonReader reader(body);
+            const JsonReader::Token token = reader.peek();
+            if (token != JsonReader::ArrayBegin) {
+                const ErrorResult err = token == JsonReader::Invalid ? invalid : unexpected;
+                mailbox.post([errorCb, err]() mutable { emitError(errorCb, err); });
+                return;
+            }
+
+            auto result = decode(reader);
+            if (reader.hasError() || !reader.atEnd()) {
+                mailbox.post([errorCb, invalid]() mutable { emitError(errorCb, invalid); });
+                return;
+            }
+
+            mailbox.deliver(std::move(result), std::move(fn));
+        }));
+    }
+
+    // One-shot channel from a worker thread back to the thread `context`
+    // lives in. It is created on that thread and owns a private receiver
+    // object there, so posting stays safe even if `context` is destroyed
+    // while the worker runs; the callback is then simply dropped.
+    class Mailbox
+    {
+    public:
+        explicit Mailbox(QObject* context)
+            : m_context(context), m_receiver(new QObject) {}
+
+        // Moves `value` to the receiving thread; the queued call holds it
+        // behind a shared pointer so it is never copied.
+        template<typename T, typename Fn>
+        void deliver(T&& value, Fn&& fn) const
+        {
+            auto slot = std::make_shared<std::decay_t<T>>(std::forward<T>(value));
+            post([slot, fn = std::forward<Fn>(fn)]() mutable {
+                fn(std::move(*slot));
+            });
+        }
+
+        template<typename Fn>
+        void post(Fn&& fn) const
+        {
+            QObject* receiver = m_receiver;
+            QMetaObject::invokeMethod(receiver, [
+                receiver,
+                context = m_context,
+                fn = shareCallable(std::forward<Fn>(fn))
+            ]() mutable {
+                if (context) fn();
+                receiver->deleteLater();
+            }, Qt::QueuedConnection);
+        }
+
+    private:
+        QPointer<QObject> m_context;
+        QObject* m_receiver;
+    };
+
     template<typename Fn>
     requires std::invocable<Fn, const QString&>
     static void expectString(QRestReply& reply, ErrorCb& errorCb, Fn&& fn)
@@ -1,12 +1,14 @@
 #include "HttpClient.h"
 
 #include <QHttpHeaders>
+#include <QSslCertificate>
+#include <QSslConfiguration>
 #include <QtGlobal>
 #include <cmath>
 
 HttpClient::HttpClient(QObject *parent)
     : QObject(parent)
-    , m_rest(&m_nam, this)
+    , m_transport(new HttpTransport(this))
     , m_factory(QUrl())
 {
     QHttpHeaders headers;
@@ -15,11 +17,12 @@ HttpClient::HttpClient(QObject *parent)
     m_factory.setCommonHeaders(headers);
 
     m_factory.setTransferTimeout(std::chrono::seconds(15));
+    m_handlePool.reserve(MaxPooledHandles);
 }
 
 HttpClient::HttpClient(const QUrl& baseUrl, QObject *parent)
     : QObject(parent)
-    , m_rest(&m_nam, this)
+    , m_transport(new HttpTransport(this))
     , m_factory(baseUrl)
 {
     QHttpHeaders headers;
@@ -28,6 +31,43 @@ HttpClient::HttpClient(const QUrl& baseUrl, QObject *parent)
     m_factory.setCommonHeaders(headers);
 
     m_factory.setTransferTimeout(std::chrono::seconds(15));
+    m_handlePool.reserve(MaxPooledHandles);
+}
+
+HttpClient::~HttpClient()
+{
+    // The transport is deleted on its own thread once the loop has stopped
+    if (m_ioThread) {
+        m_ioThread->quit();
+        m_ioThread->wait();
+    }
+}
+
+void HttpClient::setNetworkThreadEnabled(bool enabled)
+{
+    if (enabled == networkThreadEnabled()) return;
+    if (m_nextRequestId > 0) {
+        qWarning().noquote() << "[NETWORK] Network thread" << (enabled ? "enabled" : "disabled")
+                             << "after the first request; applies after a restart";
+        return;
+    }
+
+    if (enabled) {
+        m_ioThread = new QThread(this);
+        m_ioThread->setObjectName("HttpClient I/O");
+        m_transport->setParent(nullptr);
+        m_transport->moveToThread(m_ioThread);
+        connect(m_ioThread, &QThread::finished, m_transport, &QObject::deleteLater);
+        m_ioThread->start();
+    } else {
+        m_ioThread->quit();
+        m_ioThread->wait();
+        delete m_ioThread;
+        m_ioThread = nullptr;
+        m_transport = new HttpTransport(this);
+        m_transport->setTlsSessionCache(m_tlsSessions);
+    }
+    qDebug().noquote() << "[NETWORK] Network thread" << (enabled ? "enabled" : "disabled");
 }
 
 void HttpClient::setBaseUrl(const QUrl& baseUrl)
@@ -35,14 +75,454 @@ void HttpClient::setBaseUrl(const QUrl& baseUrl)
     m_factory.setBaseUrl(baseUrl);
 }
 
+void HttpClient::setTransferTimeout(int ms)
+{
+    m_factory.setTransferTimeout(std::chrono::milliseconds(ms));
+}
+
+void HttpClient::setDefaultRetryPolicy(const RetryPolicy& policy)
+{
+    m_defaultRetryPolicy = std::make_shared<const RetryPolicy>(policy);
+}
+
+void HttpClient::warmUp(const QUrl& url)
+{
+    if (!url.isValid() || url.host().isEmpty()) return;
+
+    QMetaObject::invokeMethod(m_transport, [transport = m_transport, url]() {
+        transport->warmUp(url);
+    });
+}
+
+void HttpClient::setKeepWarm(const QUrl& url, int idleSec)
+{
+    QMetaObject::invokeMethod(m_transport, [transport = m_transport, url, idleSec]() {
+        transport->keepWarm(url, idleSec);
+    });
+}
+
+void HttpClient::setTlsSessionCache(TlsSessionCache* cache)
+{
+    m_tlsSessions = cache;
+    QMetaObject::invokeMethod(m_transport, [transport = m_transport, cache]() {
+        transport->setTlsSessionCache(cache);
+    });
+}
+
+bool HttpClient::addCaCertificates(const QString& path)
+{
+    const QList<QSslCertificate> certs = QSslCertificate::fromPath(path, QSsl::Pem);
+    if (certs.isEmpty()) {
+        qWarning().noquote() << "[NETWORK] No certificates in" << path;
+        return false;
+    }
+
+    QSslConfiguration ssl = QSslConfiguration::defaultConfiguration();
+    const QList<QSslCertificate> trusted = ssl.caCertificates();
+    for (const QSslCertificate& cert : certs) {
+        if (!trusted.contains(cert)) ssl.addCaCertificate(cert);
+    }
+    QSslConfiguration::setDefaultConfiguration(ssl);
+    return true;
+}
+
 void HttpClient::setBearerToken(const QByteArray& token)
 {
     m_factory.setBearerToken(token);
+    ++m_tokenGeneration;
 }
 
 void HttpClient::clearBearerToken()
 {
     m_factory.setBearerToken(QByteArray{});
+    ++m_tokenGeneration;
+}
+
+void HttpClient::setTokenRefresher(TokenRefresher refresher)
+{
+    m_tokenRefresher = std::move(refresher);
+}
+
+void HttpClient::finishRefresh(bool refreshed)
+{
+    m_refreshing = false;
+
+    // Replays may park again (e.g. the new token is rejected too); they then
+    // wait for a fresh refresh rather than this batch
+    decltype(m_parked) parked;
+    parked.swap(m_parked);
+
+    qDebug().noquote() << "[NETWORK] Token refresh" << (refreshed ? "succeeded," : "failed,")
+                       << (refreshed ? "replaying" : "failing") << parked.size() << "request(s)";
+
+    for (auto& resume : parked)
+        resume(refreshed);
+}
+
+void RequestHandle::abort()
+{
+    if (m_aborted.exchange(true, std::memory_order_acq_rel)) return;
+
+    // Cancelled and pooled once the current callback returned, like deleteLater()
+    QMetaObject::invokeMethod(this, [this]() {
+        if (m_id != 0 && aborted())
+            static_cast<HttpClient*>(parent())->recycle(this);
+    }, Qt::QueuedConnection);
+}
+
+RequestHandle* HttpClient::acquireHandle()
+{
+    RequestHandle* handle;
+    if (m_handlePool.empty()) {
+        handle = new RequestHandle(this);
+    } else {
+        handle = m_handlePool.back();
+        m_handlePool.pop_back();
+    }
+    handle->m_aborted.store(false, std::memory_order_release);
+    handle->m_id = ++m_nextRequestId;
+    return handle;
+}
+
+void HttpClient::recycle(RequestHandle* handle)
+{
+    if (handle->m_id == 0) return;
+
+    // An aborted request may still be queued, parked or on the wire; those
+    // drop it once they see the id changed. The transport is told here.
+    if (handle->aborted()) {
+        if (!m_ioThread) {
+            m_transport->cancel(handle->m_id);
+        } else {
+            QMetaObject::invokeMethod(m_transport, [transport = m_transport, id = handle->m_id]() {
+                transport->cancel(id);
+            });
+        }
+    }
+
+    handle->disconnect();   // the caller's connections to its signals
+    if (handle->m_stream) delete handle->m_stream->pump;
+    handle->m_id = 0;
+    handle->m_urlOrPath.clear();
+    handle->m_data.clear();
+    handle->m_callback = nullptr;
+    handle->m_policy.reset();
+    handle->m_stream.reset();
+    handle->m_tokenGeneration = 0;
+    handle->m_replayed = false;
+
+    if (m_handlePool.size() < size_t(MaxPooledHandles))
+        m_handlePool.push_back(handle);
+    else
+        handle->deleteLater();
+}
+
+void HttpClient::attempt(RequestHandle* handle, int attemptNo, int delayMs)
+{
+    if (handle->aborted()) return;
+
+    QNetworkRequest request = buildRequest(handle->m_urlOrPath);
+    if (!request.url().isValid()) {
+        emit handle->attempt(attemptNo);
+        fail(handle, QNetworkReply::ProtocolUnknownError, QStringLiteral("Invalid URL"));
+        return;
+    }
+    if (!m_limiter || (delayMs <= 0 && m_limiter->tryAcquire(request.url()))) {
+        sendAttempt(handle, attemptNo, delayMs, std::move(request));
+        return;
+    }
+
+    // The delay runs here instead of on the transport's thread, so a retry
+    // queues behind a pause of its host. The request is rebuilt when it is
+    // let through, in case the bearer token changed meanwhile.
+    m_limiter->acquire(request.url(), delayMs, [this, ticket = RequestTicket(handle), attemptNo]() {
+        RequestHandle* h = ticket.live();
+        if (!h) return false;
+        sendAttempt(h, attemptNo, 0, buildRequest(h->m_urlOrPath));
+        return true;
+    });
+}
+
+void HttpClient::sendAttempt(RequestHandle* handle, int attemptNo, int delayMs, QNetworkRequest request)
+{
+    emit handle->attempt(attemptNo);
+
+    if (RequestStream* stream = handle->m_stream.get(); stream && stream->upload) {
+        if (!stream->source || !stream->source->isReadable()) {
+            fail(handle, QNetworkReply::UnknownContentError, QStringLiteral("Upload source is not readable"));
+            return;
+        }
+        if (!stream->source->isSequential())
+            stream->source->seek(stream->sourcePos);
+    }
+
+    logAttempt(handle->m_verb, request.url(), attemptNo);
+    handle->m_tokenGeneration = m_tokenGeneration;
+
+    send(handle, handle->m_verb, request, handle->m_data, delayMs,
+         [this, ticket = RequestTicket(handle), attemptNo](QRestReply& reply) { onReply(ticket, attemptNo, reply); },
+         handle->m_stream);
+}
+
+void HttpClient::onReply(const RequestTicket& ticket, int attemptNo, QRestReply& reply)
+{
+    if (m_limiter && reply.networkReply())
+        m_limiter->observe(reply.networkReply()->url(), reply.httpStatus(), reply.networkReply()->headers());
+
+    RequestHandle* handle = ticket.live();
+    if (!handle) return;
+
+    if (reply.isSuccess()) {
+        complete(handle, reply, true);
+        return;
+    }
+
+    if (reply.httpStatus() == 401 && parkUnauthorized(handle, attemptNo))
+        return;
+
+    const RetryPolicy& policy = *handle->m_policy;
+    const bool willRetry = (!handle->m_stream || handle->m_stream->replayable())
+                        && shouldRetry(reply, policy, attemptNo);
+    if (!willRetry) {
+        complete(handle, reply, false);
+        return;
+    }
+
+    qDebug().noquote() << "[NETWORK] Retry:" << reply.httpStatus() << reply.networkReply()->errorString();
+
+    // The delay runs on the transport's thread, or in the rate limiter
+    attempt(handle, attemptNo + 1, retryDelayMs(reply, policy, attemptNo));
+}
+
+void HttpClient::complete(RequestHandle* handle, QRestReply& reply, bool ok)
+{
+    if (ok) {
+        emit handle->finished(reply);
+    } else {
+        emit networkError(reply.errorString(), reply.httpStatus());
+        emit handle->failed(reply.errorString(), reply.httpStatus());
+    }
+    handle->m_callback(reply);
+    recycle(handle);
+}
+
+void HttpClient::fail(RequestHandle* handle, QNetworkReply::NetworkError error, const QString& message)
+{
+    // Queued like the transport's failures: this may run before get() and
+    // friends returned the handle, and a caller connecting to it then must
+    // still see failed(), not the next request's signals. The callback gets
+    // a stand-in reply carrying the error, like after a network failure.
+    QMetaObject::invokeMethod(this, [this, ticket = RequestTicket(handle), error, message]() {
+        RequestHandle* h = ticket.live();
+        if (!h) return;
+
+        ReplySnapshot snapshot;
+        snapshot.request = buildRequest(h->m_urlOrPath);
+        snapshot.url = snapshot.request.url();
+        snapshot.error = error;
+        snapshot.errorString = message;
+        QNetworkReply* nr = new CompletedReply(std::move(snapshot), this);
+        QRestReply reply(nr);
+        complete(h, reply, false);
+        nr->deleteLater();
+    }, Qt::QueuedConnection);
+}
+
+bool HttpClient::parkUnauthorized(RequestHandle* handle, int attemptNo)
+{
+    if (!m_tokenRefresher || handle->m_replayed) return false;
+    if (handle->m_stream && !handle->m_stream->replayable()) return false;
+    handle->m_replayed = true;
+
+    // The token changed while this request was in flight: the refresh
+    // it needs has already happened
+    if (handle->m_tokenGeneration != m_tokenGeneration) {
+        qDebug().noquote() << "[NETWORK] 401 with a stale token, replaying";
+        attempt(handle, attemptNo);
+        return true;
+    }
+
+    m_parked.push_back([this, ticket = RequestTicket(handle), attemptNo](bool refreshed) {
+        RequestHandle* h = ticket.live();
+        if (!h) return;
+
+        if (refreshed) {
+            attempt(h, attemptNo);
+            return;
+        }
+
+        // The original reply is gone by now; fail with a stand-in 401
+        QNetworkReply* nr = unauthorizedReply(buildRequest(h->m_urlOrPath));
+        QRestReply reply(nr);
+        complete(h, reply, false);
+        nr->deleteLater();
+    });
+
+    if (!m_refreshing) {
+        m_refreshing = true;
+        qDebug().noquote() << "[NETWORK] 401: refreshing token";
+        m_tokenRefresher([guard = QPointer<HttpClient>(this)](bool refreshed) {
+            if (guard) guard->finishRefresh(refreshed);
+        });
+    }
+    return true;
+}
+
+const std::shared_ptr<const RetryPolicy>& HttpClient::singleAttempt()
+{
+    static const auto policy = std::make_shared<const RetryPolicy>(RetryPolicy{ .maxAttempts = 1 });
+    return policy;
+}
+
+void HttpClient::send(RequestHandle* handle, Verb verb, const QNetworkRequest& request, const QByteArray& data,
+                      int delayMs, HttpTransport::Completion done, const std::shared_ptr<RequestStream>& stream)
+{
+    const quint64 id = handle->m_id;
+    if (!m_ioThread) {
+        m_transport->send(id, verb, request, data, delayMs, std::move(done), streamingFor(handle, stream));
+        return;
+    }
+
+    // The reply is read into a snapshot on the I/O thread; the callback
+    // gets a completed stand-in reply here
+    auto deliver = [this, done = shareCallable(std::move(done))](QRestReply& reply) {
+        QMetaObject::invokeMethod(this, [this, done, snapshot = ReplySnapshot::take(reply)]() mutable {
+            QNetworkReply* nr = new CompletedReply(std::move(snapshot), this);
+            QRestReply restReply(nr);
+            done(restReply);
+            nr->deleteLater();
+        }, Qt::QueuedConnection);
+    };
+    auto streaming = std::make_shared<HttpTransport::Streaming>(streamingFor(handle, stream));
+
+    QMetaObject::invokeMethod(m_transport, [transport = m_transport, id, verb, request, data, delayMs, deliver, streaming]() {
+        transport->send(id, verb, request, data, delayMs, deliver, std::move(*streaming));
+    }, Qt::QueuedConnection);
+}
+
+HttpTransport::Streaming HttpClient::streamingFor(RequestHandle* handle, const std::shared_ptr<RequestStream>& stream)
+{
+    HttpTransport::Streaming streaming;
+    if (!stream) return streaming;
+
+    const quint64 id = handle->m_id;
+    const RequestTicket ticket(handle);
+
+    // The hooks run on the transport's thread; `here` brings them back
+    const auto here = [this](auto f) {
+        if (m_ioThread) QMetaObject::invokeMethod(this, std::move(f), Qt::QueuedConnection);
+        else f();
+    };
+
+    if (stream->upload) {
+        streaming.size = stream->size;
+        if (!m_ioThread) {
+            streaming.source = stream->source;
+        } else {
+            // QNetworkAccessManager reads on the I/O thread, so the source is
+            // read here and handed over chunk by chunk
+            delete stream->pump;
+            stream->pump = new StreamPump(stream->source, stream->size,
+                                          [transport = m_transport, id](const QByteArray& chunk, bool last) {
+                QMetaObject::invokeMethod(transport, [transport, id, chunk, last]() {
+                    transport->feed(id, chunk, last);
+                }, Qt::QueuedConnection);
+            }, handle);
+            streaming.pipeSource = true;
+            streaming.onSourceDrained = [here, pump = stream->pump]() {
+                here([pump]() { if (pump) pump->pump(); });
+            };
+        }
+    }
+
+    if (stream->sink || stream->onChunk) {
+        streaming.onChunk = [this, here, ticket, stream, id](const QByteArray& chunk) {
+            here([this, ticket, stream, id, chunk]() {
+                if (RequestHandle* h = ticket.live())
+                    deliverChunk(h, *stream, chunk);
+                QMetaObject::invokeMethod(m_transport, [transport = m_transport, id, n = chunk.size()]() {
+                    transport->consumed(id, n);
+                });
+            });
+        };
+    }
+
+    streaming.onProgress = [here, ticket](bool upload, qint64 done, qint64 total) {
+        here([ticket, upload, done, total]() {
+            RequestHandle* h = ticket.live();
+            if (!h) return;
+            if (upload) emit h->uploadProgress(done, total);
+            else        emit h->downloadProgress(done, total);
+        });
+    };
+    return streaming;
+}
+
+void HttpClient::deliverChunk(RequestHandle* handle, RequestStream& stream, const QByteArray& chunk)
+{
+    stream.delivered += chunk.size();
+    if (stream.onChunk) {
+        stream.onChunk(chunk);
+        return;
+    }
+    if (stream.sinkFailed) return;
+    if (stream.sink && stream.sink->write(chunk) == chunk.size()) return;
+
+    stream.sinkFailed = true;
+    qWarning().noquote() << "[NETWORK] Download sink failed:"
+                         << (stream.sink ? stream.sink->errorString() : QStringLiteral("deleted"));
+    QMetaObject::invokeMethod(m_transport, [transport = m_transport, id = handle->m_id]() {
+        transport->interrupt(id);
+    });
+}
+
+std::shared_ptr<RequestStream> HttpClient::uploadFrom(QIODevice* source, qint64 size)
+{
+    auto stream = std::make_shared<RequestStream>();
+    stream->upload = true;
+    stream->source = source;
+    if (source) {
+        stream->sourcePos = source->pos();
+        if (size < 0 && !source->isSequential())
+            size = source->size() - source->pos();
+    }
+    stream->size = size;
+    return stream;
+}
+
+std::shared_ptr<RequestStream> HttpClient::downloadTo(QIODevice* sink, ChunkHandler onChunk)
+{
+    auto stream = std::make_shared<RequestStream>();
+    stream->sink = sink;
+    stream->onChunk = std::move(onChunk);
+    return stream;
+}
+
+QNetworkReply* HttpClient::unauthorizedReply(const QNetworkRequest& request)
+{
+    // Handed to requests parked for a token refresh which then failed;
+    // their original replies are deleted by then
+    ReplySnapshot snapshot;
+    snapshot.request = request;
+    snapshot.url = request.url();
+    snapshot.httpStatus = 401;
+    snapshot.reasonPhrase = "Unauthorized";
+    snapshot.error = QNetworkReply::AuthenticationRequiredError;
+    snapshot.errorString = QStringLiteral("Session expired");
+    return new CompletedReply(std::move(snapshot), this);
+}
+
+void HttpClient::logAttempt(Verb verb, const QUrl& url, int attemptNo)
+{
+    switch (verb) {
+    case Verb::Get:
+        qDebug().noquote() << QStringLiteral("[NETWORK] Fetch (%1): %2").arg(attemptNo).arg(url.toString()).toStdString();
+        return;
+    case Verb::Post:   qDebug().noquote() << QStringLiteral("[NETWORK] POST: %1").arg(url.toString()).toStdString(); return;
+    case Verb::Put:    qDebug().noquote() << QStringLiteral("[NETWORK] PUT: %1").arg(url.toString()).toStdString(); return;
+    case Verb::Patch:  qDebug().noquote() << QStringLiteral("[NETWORK] PATCH: %1").arg(url.toString()).toStdString(); return;
+    case Verb::Delete: qDebug().noquote() << QStringLiteral("[NETWORK] DELETE: %1").arg(url.toString()).toStdString(); return;
+    }
 }
 
 QNetworkRequest HttpClient::buildRequest(const QString& urlOrPath) const
@@ -69,10 +549,12 @@ int HttpClient::retryDelayMs(const RetryPolicy& policy, int attemptNo)
     return qBound(0, ms, policy.maxDelayMs);
 }
 
-void HttpClient::autoDeleteHandle(RequestHandle *handle)
+int HttpClient::retryDelayMs(const QRestReply& reply, const RetryPolicy& policy, int attemptNo)
 {
-    QObject::connect(handle, &RequestHandle::finished, handle, &QObject::deleteLater);
-    QObject::connect(handle, &RequestHandle::failed,   handle, &QObject::deleteLater);
+    const int backoff = retryDelayMs(policy, attemptNo);
+    if (!reply.networkReply()) return backoff;
+    const qint64 serverDelay = RateLimiter::retryAfterMs(reply.networkReply()->headers());
+    return int(qMax<qint64>(backoff, qMin<qint64>(serverDelay, policy.maxRetryAfterMs)));
 }
 
 bool HttpClient::shouldRetry(const QRestReply& reply, const RetryPolicy& policy, int attemptNo) const
@@ -80,6 +562,11 @@ bool HttpClient::shouldRetry(const QRestReply& reply, const RetryPolicy& policy,
     if (attemptNo >= policy.maxAttempts)
         return false;
 
+    // Longer than the caller is willing to wait
+    if (reply.networkReply()
+        && RateLimiter::retryAfterMs(reply.networkReply()->headers()) > policy.maxRetryAfterMs)
+        return false;
+
     if (policy.shouldRetry)
         return policy.shouldRetry(reply);
 
@@ -2,23 +2,36 @@
 
 #include <QObject>
 #include <QByteArray>
+#include <QIODevice>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QNetworkRequestFactory>
+#include <QPointer>
 #include <QRestAccessManager>
 #include <QRestReply>
+#include <QThread>
 #include <QTimer>
 #include <QUrl>
 #include <QDebug>
+#include <atomic>
 #include <concepts>
 #include <functional>
+#include <memory>
+#include <vector>
+#include "HttpTransport.h"
+#include "RateLimiter.h"
+#include "TlsSessionCache.h"
+#include "UniqueFunction.h"
 
 struct RetryPolicy {
     int maxAttempts = 3;
     int baseDelayMs = 200;
     double multiplier = 2.0;
     int maxDelayMs = 5000;
+    // A Retry-After replaces the backoff when longer; one longer than this
+    // fails the request instead
+    int maxRetryAfterMs = 30000;
 
     bool retryOnNetworkError = true;
     QList<int> retryHttpStatus = { 408, 429, 500, 502, 503, 504 };
@@ -26,33 +39,108 @@ struct RetryPolicy {
     std::function<bool(const QRestReply&)> shouldRetry = {};
 };
 
+class HttpClient;
+
+// Streamed body parts of one request, shared by its attempts
+struct RequestStream {
+    bool upload = false;
+    QPointer<QIODevice> source;   // request body, instead of the data
+    qint64 sourcePos = 0;         // where every attempt starts reading
+    qint64 size = -1;
+    QPointer<StreamPump> pump;    // current attempt's, with a network thread
+
+    QPointer<QIODevice> sink;     // 2xx response body, or
+    UniqueFunction<void(const QByteArray&)> onChunk;
+    qint64 delivered = 0;         // response bytes streamed so far
+    bool sinkFailed = false;
+
+    // Whether another attempt would repeat what was already streamed
+    bool replayable() const
+    {
+        return delivered == 0 && (!upload || (source && !source->isSequential()));
+    }
+};
+
+// Caller-side proxy for one request, across its retries and replays.
+//
+// Handles are pooled by their HttpClient and carry the request's state, so
+// a request allocates neither. Once finished() or failed() was emitted, or
+// after abort(), the handle goes back to the pool and later stands for
+// another request: connect to it right away, and keep a RequestTicket
+// rather than the pointer to abort it later.
+//
+// The handle is used on the thread the HttpClient lives in, which is also
+// where its signals are emitted, whichever thread the transport runs on.
+// aborted() may be read from any thread.
 class RequestHandle : public QObject {
     Q_OBJECT
 
 public:
     explicit RequestHandle(QObject* parent = nullptr) : QObject(parent) {}
 
-    Q_INVOKABLE void abort() {
-        if (m_aborted) return;
-        m_aborted = true;
-        deleteLater();
-    }
+    Q_INVOKABLE void abort();
 
-    bool aborted() const { return m_aborted; }
+    bool aborted() const { return m_aborted.load(std::memory_order_acquire); }
 
 signals:
     void attempt(int n);
+    // Streamed requests only; `total` is -1 while unknown
+    void uploadProgress(qint64 sent, qint64 total);
+    void downloadProgress(qint64 received, qint64 total);
     void finished(QRestReply &reply);
     void failed(QString message, int httpStatus);
 
 private:
     friend class HttpClient;
-    bool m_aborted = false;
+
+    // Large enough for the callbacks the API classes pass
+    using Callback = UniqueFunction<void(QRestReply&), 16 * sizeof(void*)>;
+
+    friend class RequestTicket;
+
+    std::atomic<bool> m_aborted{ false };
+    quint64 m_id = 0;   // 0 while pooled
+
+    // Shared by every attempt; reset when the handle is pooled
+    HttpTransport::Verb m_verb = HttpTransport::Verb::Get;
+    QString m_urlOrPath;
+    QByteArray m_data;
+    Callback m_callback;
+    std::shared_ptr<const RetryPolicy> m_policy;
+    std::shared_ptr<RequestStream> m_stream;
+    quint64 m_tokenGeneration = 0;   // bearer token the last attempt went out with
+    bool m_replayed = false;         // replayed after a 401 at most once
+};
+
+// One request of a pooled RequestHandle. Unlike a pointer to the handle it
+// goes stale once the request is over, so a late abort() cannot reach the
+// request the handle stands for by then. Same thread rules as the handle.
+class RequestTicket {
+public:
+    RequestTicket() = default;
+    explicit RequestTicket(RequestHandle* handle) : m_handle(handle), m_id(handle ? handle->m_id : 0) {}
+
+    // The handle while it still stands for this, unaborted, request
+    RequestHandle* live() const
+    {
+        return m_handle && m_id != 0 && m_handle->m_id == m_id && !m_handle->aborted() ? m_handle.data() : nullptr;
+    }
+
+    // Aborts the request unless it is already over
+    void abort() const
+    {
+        if (RequestHandle* handle = live()) handle->abort();
+    }
+
+private:
+    QPointer<RequestHandle> m_handle;
+    quint64 m_id = 0;
 };
 
 class HttpClient : public QObject
 {
     Q_OBJECT
+    friend class RequestHandle;
 
 public:
 signals:
@@ -61,188 +149,247 @@ signals:
 public:
     explicit HttpClient(QObject *parent = nullptr);
     explicit HttpClient(const QUrl& baseUrl = {}, QObject *parent = nullptr);
+    ~HttpClient() override;
+
+    // Runs the transport (QNetworkAccessManager, sockets, TLS, retry
+    // delays) on a dedicated I/O thread, so a busy thread here no longer
+    // stalls network progress. Replies are snapshotted on the I/O thread
+    // and callbacks still run on this object's thread. Only honoured
+    // before the first request.
+    void setNetworkThreadEnabled(bool enabled);
+    bool networkThreadEnabled() const { return m_ioThread != nullptr; }
 
     void setBaseUrl(const QUrl& baseUrl);
+
+    // Resolves `url`'s host and opens a (TLS) connection to it ahead of
+    // the first request
+    void warmUp(const QUrl& url);
+
+    // Warms `url` up again after about `idleSec` without requests; 0 or an
+    // empty URL turns it off
+    void setKeepWarm(const QUrl& url, int idleSec);
+
+    // Resumes TLS sessions from `cache` and stores new ones in it. The
+    // cache may be shared between clients and must outlive them.
+    void setTlsSessionCache(TlsSessionCache* cache);
+
+    // Sends every request through `limiter`'s bucket for its host, which
+    // also adapts to the server's throttling headers. The limiter may be
+    // shared between clients on this thread and must outlive them; null
+    // sends right away.
+    void setRateLimiter(RateLimiter* limiter) { m_limiter = limiter; }
+
+    // Trusts the PEM certificates in `path` on top of the system CAs, in
+    // every client; e.g. the self-signed certificate of a test server
+    static bool addCaCertificates(const QString& path);
+
+    // Both apply to requests started afterwards
+    void setTransferTimeout(int ms);
+    void setDefaultRetryPolicy(const RetryPolicy& policy);
+    const RetryPolicy& defaultRetryPolicy() const { return *m_defaultRetryPolicy; }
     void setBearerToken(const QByteArray& token);
     void clearBearerToken();
 
-    QRestAccessManager& rest() { return m_rest; }
+    // Request for a path relative to the base URL, or an absolute URL, with
+    // the factory's headers and bearer token applied
+    QNetworkRequest buildRequest(const QString& urlOrPath) const;
+
+    // Backoff before attempt `attemptNo + 1` under `policy`
+    static int retryDelayMs(const RetryPolicy& policy, int attemptNo);
+    // The same, unless `reply` asks for a longer Retry-After
+    static int retryDelayMs(const QRestReply& reply, const RetryPolicy& policy, int attemptNo);
+
     QNetworkRequestFactory& factory() { return m_factory; }
 
+    // Obtains a fresh bearer token after a 401. It must call setBearerToken()
+    // and then done(true), or done(false) if the session cannot be renewed.
+    using TokenRefresher = std::function<void(std::function<void(bool refreshed)> done)>;
+
+    // With a refresher set, a request answered with 401 is parked instead of
+    // failing. All requests parked meanwhile share a single refresh and are
+    // replayed once with the new token, or failed together if it fails.
+    void setTokenRefresher(TokenRefresher refresher);
+
     template<typename Functor>
     requires std::invocable<Functor, QRestReply &>
     RequestHandle* get(const QString& urlOrPath, Functor&& callback)
     {
-        return get(urlOrPath, std::forward<Functor>(callback), RetryPolicy{});
+        return start(Verb::Get, urlOrPath, {}, std::forward<Functor>(callback), m_defaultRetryPolicy);
     }
 
     template<typename Functor>
     requires std::invocable<Functor, QRestReply &>
     RequestHandle* get(const QString& urlOrPath, Functor&& callback, RetryPolicy policy)
     {
-        auto* handle = new RequestHandle(this);
-        autoDeleteHandle(handle);
-
-        auto doAttempt = [
-            this,
-            handle,
-            urlOrPath,
-            cb = std::forward<Functor>(callback),
-            policy
-        ](auto&& self, int attemptNo) mutable -> void {
-            if (handle->aborted()) return;
-            emit handle->attempt(attemptNo);
-
-            const QNetworkRequest req = buildRequest(urlOrPath);
-            const QUrl url = req.url();
-            if (!url.isValid()) {
-                emit handle->failed("Invalid URL", 0);
-                return;
-            }
-
-            qDebug().noquote() << QStringLiteral("[NETWORK] Fetch (%1): %2").arg(attemptNo).arg(req.url().toString()).toStdString();
-
-            m_rest.get(req, handle, [this, handle, cb, policy, attemptNo, self](QRestReply &reply) mutable {
-                if (!handle || handle->aborted()) return;
-
-                if (reply.isSuccess()) {
-                    emit handle->finished(reply);
-                    cb(reply);
-                    return;
-                }
-
-                qDebug().noquote() << "[NETWORK] Retry:" << reply.httpStatus() << reply.networkReply()->errorString();
-
-                const bool willRetry = shouldRetry(reply, policy, attemptNo);
-                if (!willRetry) {
-                    emit networkError(reply.errorString(), reply.httpStatus());
-                    emit handle->failed(reply.errorString(), reply.httpStatus());
-                    cb(reply);
-                    return;
-                }
-
-                const int delay = retryDelayMs(policy, attemptNo);
-                QTimer::singleShot(delay, handle, [handle, self, attemptNo]() mutable {
-                    if (!handle || handle->aborted()) return;
-                    self(self, attemptNo + 1);
-                });
-            });
-        };
-
-        doAttempt(doAttempt, 1);
-        return handle;
+        return start(Verb::Get, urlOrPath, {}, std::forward<Functor>(callback),
+                     std::make_shared<const RetryPolicy>(std::move(policy)));
     }
 
+    // Handles a streamed response body, chunk by chunk
+    using ChunkHandler = UniqueFunction<void(const QByteArray& chunk)>;
+
+    // Streamed downloads: a 2xx body goes to `sink` or `onChunk` as it
+    // arrives, so `callback` gets a reply without body; other statuses keep
+    // their body in the reply. Retries and the 401 replay only happen while
+    // nothing has been streamed. If `sink` stops accepting writes the
+    // request is aborted and fails with OperationCanceledError.
     template<typename Functor>
-    requires std::invocable<Functor, QRestReply&>
-    RequestHandle* post(const QString& urlOrPath, const QByteArray& data, Functor&& callback)
+    requires std::invocable<Functor, QRestReply &>
+    RequestHandle* get(const QString& urlOrPath, QIODevice* sink, Functor&& callback)
+    {
+        return start(Verb::Get, urlOrPath, {}, std::forward<Functor>(callback), m_defaultRetryPolicy,
+                     downloadTo(sink, {}));
+    }
+
+    template<typename Functor>
+    requires std::invocable<Functor, QRestReply &>
+    RequestHandle* get(const QString& urlOrPath, QIODevice* sink, Functor&& callback, RetryPolicy policy)
     {
-        auto* handle = new RequestHandle(this);
-        autoDeleteHandle(handle);
-        emit handle->attempt(1);
+        return start(Verb::Get, urlOrPath, {}, std::forward<Functor>(callback),
+                     std::make_shared<const RetryPolicy>(std::move(policy)), downloadTo(sink, {}));
+    }
 
-        const QNetworkRequest req = buildRequest(urlOrPath);
-        if (!req.url().isValid()) {
-            emit handle->failed("Invalid URL", 0);
-            return handle;
-        }
+    template<typename Functor>
+    requires std::invocable<Functor, QRestReply &>
+    RequestHandle* get(const QString& urlOrPath, ChunkHandler onChunk, Functor&& callback)
+    {
+        return start(Verb::Get, urlOrPath, {}, std::forward<Functor>(callback), m_defaultRetryPolicy,
+                     downloadTo(nullptr, std::move(onChunk)));
+    }
 
-        qDebug().noquote() << QStringLiteral("[NETWORK] POST: %1").arg(req.url().toString()).toStdString();
+    template<typename Functor>
+    requires std::invocable<Functor, QRestReply &>
+    RequestHandle* get(const QString& urlOrPath, ChunkHandler onChunk, Functor&& callback, RetryPolicy policy)
+    {
+        return start(Verb::Get, urlOrPath, {}, std::forward<Functor>(callback),
+                     std::make_shared<const RetryPolicy>(std::move(policy)), downloadTo(nullptr, std::move(onChunk)));
+    }
 
-        m_rest.post(req, data, handle, makeReplyHandler(handle, std::forward<Functor>(callback)));
-        return handle;
+    template<typename Functor>
+    requires std::invocable<Functor, QRestReply&>
+    RequestHandle* post(const QString& urlOrPath, const QByteArray& data, Functor&& callback)
+    {
+        return start(Verb::Post, urlOrPath, data, std::forward<Functor>(callback), singleAttempt());
     }
 
     template<typename Functor>
     requires std::invocable<Functor, QRestReply&>
     RequestHandle* put(const QString& urlOrPath, const QByteArray& data, Functor&& callback)
     {
-        auto* handle = new RequestHandle(this);
-        autoDeleteHandle(handle);
-        emit handle->attempt(1);
-
-        const QNetworkRequest req = buildRequest(urlOrPath);
-        if (!req.url().isValid()) {
-            emit handle->failed("Invalid URL", 0);
-            return handle;
-        }
-
-        qDebug().noquote() << QStringLiteral("[NETWORK] PUT: %1").arg(req.url().toString()).toStdString();
-
-        m_rest.put(req, data, handle, makeReplyHandler(handle, std::forward<Functor>(callback)));
-        return handle;
+        return start(Verb::Put, urlOrPath, data, std::forward<Functor>(callback), singleAttempt());
     }
 
     template<typename Functor>
     requires std::invocable<Functor, QRestReply&>
     RequestHandle* patch(const QString& urlOrPath, const QByteArray& data, Functor&& callback)
     {
-        auto* handle = new RequestHandle(this);
-        autoDeleteHandle(handle);
-        emit handle->attempt(1);
+        return start(Verb::Patch, urlOrPath, data, std::forward<Functor>(callback), singleAttempt());
+    }
 
-        const QNetworkRequest req = buildRequest(urlOrPath);
-        if (!req.url().isValid()) {
-            emit handle->failed("Invalid URL", 0);
-            return handle;
-        }
+    // Streamed uploads: the body is read from `source` while it is sent.
+    // `source` must be open and outlive the request. Sequential sources
+    // (pipes, generators) need `size`, or Qt buffers them whole before
+    // sending. A 401 is replayed only for random-access sources. If
+    // `source` is not readable, `callback` still runs once, later, with a
+    // reply failed with UnknownContentError.
+    template<typename Functor>
+    requires std::invocable<Functor, QRestReply&>
+    RequestHandle* post(const QString& urlOrPath, QIODevice* source, Functor&& callback, qint64 size = -1)
+    {
+        return start(Verb::Post, urlOrPath, {}, std::forward<Functor>(callback), singleAttempt(),
+                     uploadFrom(source, size));
+    }
 
-        qDebug().noquote() << QStringLiteral("[NETWORK] PATCH: %1").arg(req.url().toString()).toStdString();
+    template<typename Functor>
+    requires std::invocable<Functor, QRestReply&>
+    RequestHandle* put(const QString& urlOrPath, QIODevice* source, Functor&& callback, qint64 size = -1)
+    {
+        return start(Verb::Put, urlOrPath, {}, std::forward<Functor>(callback), singleAttempt(),
+                     uploadFrom(source, size));
+    }
 
-        m_rest.patch(req, data, handle, makeReplyHandler(handle, std::forward<Functor>(callback)));
-        return handle;
+    template<typename Functor>
+    requires std::invocable<Functor, QRestReply&>
+    RequestHandle* patch(const QString& urlOrPath, QIODevice* source, Functor&& callback, qint64 size = -1)
+    {
+        return start(Verb::Patch, urlOrPath, {}, std::forward<Functor>(callback), singleAttempt(),
+                     uploadFrom(source, size));
     }
 
     template<typename Functor>
     requires std::invocable<Functor, QRestReply&>
     RequestHandle* remove(const QString& urlOrPath, Functor&& callback)
     {
-        auto* handle = new RequestHandle(this);
-        autoDeleteHandle(handle);
-        emit handle->attempt(1);
+        return start(Verb::Delete, urlOrPath, {}, std::forward<Functor>(callback), singleAttempt());
+    }
 
-        const QNetworkRequest req = buildRequest(urlOrPath);
-        if (!req.url().isValid()) {
-            emit handle->failed("Invalid URL", 0);
-            return handle;
-        }
+private:
+    using Verb = HttpTransport::Verb;
 
-        qDebug().noquote() << QStringLiteral("[NETWORK] DELETE: %1").arg(req.url().toString()).toStdString();
+    static void logAttempt(Verb verb, const QUrl& url, int attemptNo);
 
-        m_rest.deleteResource(req, handle, makeReplyHandler(handle, std::forward<Functor>(callback)));
-        return handle;
-    }
+    // Idle handles kept for reuse; more in flight at once are deleted
+    // after their request
+    static constexpr int MaxPooledHandles = 64;
 
-private:
-    QNetworkRequest buildRequest(const QString& urlOrPath) const;
+    static const std::shared_ptr<const RetryPolicy>& singleAttempt();
+    static std::shared_ptr<RequestStream> uploadFrom(QIODevice* source, qint64 size);
+    static std::shared_ptr<RequestStream> downloadTo(QIODevice* sink, ChunkHandler onChunk);
 
     template<typename Functor>
-    requires std::invocable<Functor, QRestReply&>
-    auto makeReplyHandler(RequestHandle* handle, Functor&& callback)
+    RequestHandle* start(Verb verb, const QString& urlOrPath, const QByteArray& data, Functor&& callback,
+                         std::shared_ptr<const RetryPolicy> policy, std::shared_ptr<RequestStream> stream = nullptr)
     {
-        return [this, handle, cb = std::forward<Functor>(callback)](QRestReply& reply) mutable {
-            if (!handle || handle->aborted()) return;
+        RequestHandle* handle = acquireHandle();
+        handle->m_verb = verb;
+        handle->m_urlOrPath = urlOrPath;
+        handle->m_data = data;
+        handle->m_callback = RequestHandle::Callback(std::forward<Functor>(callback));
+        handle->m_policy = std::move(policy);
+        handle->m_stream = std::move(stream);
+
+        attempt(handle, 1);
+        return handle;
+    }
 
-            if (reply.isSuccess()) {
-                emit handle->finished(reply);
-                cb(reply);
-                return;
-            }
+    RequestHandle* acquireHandle();
+    void recycle(RequestHandle* handle);
 
-            emit networkError(reply.errorString(), reply.httpStatus());
-            emit handle->failed(reply.errorString(), reply.httpStatus());
-            cb(reply);
-        };
-    }
+    // Waits for the rate limiter, if any, and for `delayMs`
+    void attempt(RequestHandle* handle, int attemptNo, int delayMs = 0);
+    void sendAttempt(RequestHandle* handle, int attemptNo, int delayMs, QNetworkRequest request);
+    void onReply(const RequestTicket& ticket, int attemptNo, QRestReply& reply);
+    void complete(RequestHandle* handle, QRestReply& reply, bool ok);
+    // Fails a request that never reached the transport
+    void fail(RequestHandle* handle, QNetworkReply::NetworkError error, const QString& message);
 
-    static int retryDelayMs(const RetryPolicy& policy, int attemptNo);
+    // Returns false when the 401 should be reported as is: no refresher, or
+    // the request was already replayed once.
+    bool parkUnauthorized(RequestHandle* handle, int attemptNo);
 
-    static void autoDeleteHandle(RequestHandle* h);
+    void send(RequestHandle* handle, Verb verb, const QNetworkRequest& request, const QByteArray& data,
+              int delayMs, HttpTransport::Completion done, const std::shared_ptr<RequestStream>& stream);
+    HttpTransport::Streaming streamingFor(RequestHandle* handle, const std::shared_ptr<RequestStream>& stream);
+    void deliverChunk(RequestHandle* handle, RequestStream& stream, const QByteArray& chunk);
+    void finishRefresh(bool refreshed);
+    QNetworkReply* unauthorizedReply(const QNetworkRequest& request);
 
     bool shouldRetry(const QRestReply& reply, const RetryPolicy& policy, int attemptNo) const;
 
 private:
-    QNetworkAccessManager m_nam;
-    QRestAccessManager m_rest;
+    HttpTransport* m_transport;
+    QThread* m_ioThread = nullptr;
+    RateLimiter* m_limiter = nullptr;
+    TlsSessionCache* m_tlsSessions = nullptr;
+    quint64 m_nextRequestId = 0;
     QNetworkRequestFactory m_factory;
+
+    // Shared, never modified: requests keep the one they started with
+    std::shared_ptr<const RetryPolicy> m_defaultRetryPolicy = std::make_shared<const RetryPolicy>();
+    std::vector<RequestHandle*> m_handlePool;
+
+    TokenRefresher m_tokenRefresher;
+    quint64 m_tokenGeneration = 0;
+    bool m_refreshing = false;
+    std::vector<UniqueFunction<void(bool), 6 * sizeof(void*)>> m_parked;
 };
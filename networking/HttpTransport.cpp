@@ -0,0 +1,406 @@
+#include "HttpTransport.h"
+
+#include <QDebug>
+#include <QTimer>
+#include <cstring>
+
+ReplySnapshot ReplySnapshot::take(QRestReply& reply)
+{
+    ReplySnapshot s;
+    QNetworkReply* nr = reply.networkReply();
+    if (!nr) return s;
+
+    s.request = nr->request();
+    s.operation = nr->operation();
+    s.url = nr->url();
+    s.httpStatus = reply.httpStatus();
+    s.reasonPhrase = nr->attribute(QNetworkRequest::HttpReasonPhraseAttribute).toByteArray();
+    s.headers = nr->headers();
+    s.error = nr->error();
+    s.errorString = nr->errorString();
+    s.body = nr->readAll();
+    return s;
+}
+
+CompletedReply::CompletedReply(ReplySnapshot snapshot, QObject* parent)
+    : QNetworkReply(parent)
+    , m_body(std::move(snapshot.body))
+{
+    setRequest(snapshot.request);
+    setUrl(snapshot.url);
+    setOperation(snapshot.operation);
+    setHeaders(std::move(snapshot.headers));
+    if (snapshot.httpStatus > 0) {
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, snapshot.httpStatus);
+        setAttribute(QNetworkRequest::HttpReasonPhraseAttribute, snapshot.reasonPhrase);
+    }
+    if (snapshot.error != QNetworkReply::NoError)
+        setError(snapshot.error, snapshot.errorString);
+    setOpenMode(QIODevice::ReadOnly);
+    setFinished(true);
+}
+
+qint64 CompletedReply::bytesAvailable() const
+{
+    return (m_body.size() - m_offset) + QNetworkReply::bytesAvailable();
+}
+
+qint64 CompletedReply::readData(char* data, qint64 maxSize)
+{
+    if (m_offset >= m_body.size()) return -1;
+
+    const qint64 n = qMin<qint64>(maxSize, m_body.size() - m_offset);
+    std::memcpy(data, m_body.constData() + m_offset, size_t(n));
+    m_offset += n;
+    return n;
+}
+
+StreamPipe::StreamPipe(QObject* parent)
+    : QIODevice(parent)
+{
+    open(QIODevice::ReadOnly);
+}
+
+void StreamPipe::append(const QByteArray& chunk)
+{
+    m_requested = false;
+    if (m_offset > 0) {
+        m_buffer.remove(0, m_offset);
+        m_offset = 0;
+    }
+    m_buffer.append(chunk);
+    emit readyRead();
+}
+
+void StreamPipe::finish()
+{
+    m_finished = true;
+    emit readyRead();
+    emit readChannelFinished();
+}
+
+bool StreamPipe::atEnd() const
+{
+    return m_finished && bytesAvailable() == 0;
+}
+
+qint64 StreamPipe::bytesAvailable() const
+{
+    return buffered() + QIODevice::bytesAvailable();
+}
+
+qint64 StreamPipe::readData(char* data, qint64 maxSize)
+{
+    const qint64 n = qMin<qint64>(maxSize, buffered());
+    if (n > 0) {
+        std::memcpy(data, m_buffer.constData() + m_offset, size_t(n));
+        m_offset += n;
+    }
+    if (!m_finished && !m_requested && buffered() < HttpTransport::ChunkSize) {
+        m_requested = true;
+        emit drained();
+    }
+    if (n == 0 && m_finished) return -1;
+    return n;
+}
+
+StreamPump::StreamPump(QIODevice* source, qint64 size, Feed feed, QObject* parent)
+    : QObject(parent)
+    , m_source(source)
+    , m_remaining(size)
+    , m_feed(std::move(feed))
+{
+    if (!source) return;
+    connect(source, &QIODevice::readyRead, this, [this]() {
+        if (m_wanted) pump();
+    });
+    connect(source, &QIODevice::readChannelFinished, this, [this]() {
+        m_sourceFinished = true;
+        if (m_wanted) pump();
+    });
+}
+
+void StreamPump::pump()
+{
+    m_wanted = true;
+    if (m_done) return;
+
+    QByteArray chunk;
+    bool ended = true;
+    if (m_source) {
+        const qint64 want = m_remaining < 0 ? HttpTransport::ChunkSize
+                                            : qMin(HttpTransport::ChunkSize, m_remaining);
+        if (want > 0) chunk = m_source->read(want);
+        if (m_remaining > 0) m_remaining -= chunk.size();
+
+        // A sequential source at its end may just have nothing yet
+        ended = !m_source->isOpen()
+             || (m_source->atEnd() && (!m_source->isSequential() || m_sourceFinished));
+    }
+    const bool last = m_remaining == 0 || ended;
+    if (chunk.isEmpty() && !last) return;   // until readyRead()
+
+    m_wanted = false;
+    m_done = last;
+    m_feed(chunk, last);
+}
+
+HttpTransport::HttpTransport(QObject* parent)
+    : QObject(parent)
+    , m_nam(this)
+    , m_rest(&m_nam, this)
+    , m_keepWarm(this)
+{
+    m_pending.reserve(MaxSpareNodes);
+    m_spareNodes.reserve(MaxSpareNodes);
+
+    // Re-armed for what is left of the idle time after a send, so the
+    // warm-up follows the last request by `idleSec` rather than by up to
+    // twice that
+    m_keepWarm.setSingleShot(true);
+    connect(&m_keepWarm, &QTimer::timeout, this, [this]() {
+        const qint64 idleMs = m_lastSend.isValid() ? m_lastSend.elapsed() : m_keepWarmMs;
+        if (idleMs < m_keepWarmMs) {
+            m_keepWarm.start(int(m_keepWarmMs - idleMs));
+            return;
+        }
+        warmUp(m_warmUrl);
+        m_keepWarm.start(m_keepWarmMs);
+    });
+}
+
+void HttpTransport::send(quint64 id, Verb verb, const QNetworkRequest& request, const QByteArray& data,
+                         int delayMs, Completion done, Streaming streaming)
+{
+    Pending& p = emplace(id, Pending{ std::move(done), {}, std::move(streaming) });
+    if (p.streaming.pipeSource) {
+        p.pipe = new StreamPipe(this);
+        p.streaming.source = p.pipe;
+        connect(p.pipe, &StreamPipe::drained, this, [this, id]() {
+            const auto it = m_pending.find(id);
+            if (it != m_pending.end() && it->second.streaming.onSourceDrained)
+                it->second.streaming.onSourceDrained();
+        });
+        // The first chunk travels while the connection is set up
+        if (p.streaming.onSourceDrained) p.streaming.onSourceDrained();
+    }
+
+    if (delayMs <= 0) {
+        dispatch(id, verb, request, data);
+        return;
+    }
+    QTimer::singleShot(delayMs, this, [this, id, verb, request, data]() {
+        if (m_pending.contains(id))
+            dispatch(id, verb, request, data);
+    });
+}
+
+void HttpTransport::cancel(quint64 id)
+{
+    const auto it = m_pending.find(id);
+    if (it == m_pending.end()) return;
+
+    const QPointer<QNetworkReply> reply = it->second.reply;
+    release(it);
+    if (reply) reply->abort();
+}
+
+void HttpTransport::interrupt(quint64 id)
+{
+    const auto it = m_pending.find(id);
+    if (it != m_pending.end() && it->second.reply)
+        it->second.reply->abort();
+}
+
+void HttpTransport::feed(quint64 id, const QByteArray& chunk, bool last)
+{
+    const auto it = m_pending.find(id);
+    if (it == m_pending.end() || !it->second.pipe) return;
+
+    if (!chunk.isEmpty()) it->second.pipe->append(chunk);
+    if (last) it->second.pipe->finish();
+}
+
+void HttpTransport::consumed(quint64 id, qint64 bytes)
+{
+    const auto it = m_pending.find(id);
+    if (it == m_pending.end()) return;
+
+    it->second.unacked -= bytes;
+    if (it->second.stalled && it->second.unacked < StreamWindow)
+        pullChunks(id, false);
+}
+
+void HttpTransport::warmUp(const QUrl& url)
+{
+    qDebug().noquote() << "[NETWORK] Warm-up:" << url.host();
+    if (url.scheme() == QLatin1String("https"))
+        m_nam.connectToHostEncrypted(url.host(), quint16(url.port(443)),
+                                     resumingSsl(url, QSslConfiguration::defaultConfiguration()));
+    else
+        m_nam.connectToHost(url.host(), quint16(url.port(80)));
+}
+
+void HttpTransport::keepWarm(const QUrl& url, int idleSec)
+{
+    m_warmUrl = url;
+    if (idleSec <= 0 || !url.isValid() || url.host().isEmpty()) {
+        m_keepWarm.stop();
+        return;
+    }
+    m_keepWarmMs = idleSec * 1000;
+    m_keepWarm.start(m_keepWarmMs);
+}
+
+void HttpTransport::dispatch(quint64 id, Verb verb, const QNetworkRequest& request, const QByteArray& data)
+{
+    m_lastSend.start();
+
+    // A cancelled id no longer has an entry, so its reply is dropped here
+    auto onReply = [this, id](QRestReply& reply) {
+        if (const auto it = m_pending.find(id); it != m_pending.end() && it->second.streaming.onChunk)
+            pullChunks(id, true);   // whatever the window held back
+
+        const auto it = m_pending.find(id);
+        if (it == m_pending.end()) return;
+
+        Completion done = std::move(it->second.done);
+        release(it);
+        done(reply);
+    };
+
+    const Streaming& streaming = m_pending.at(id).streaming;
+    QIODevice* source = streaming.source;
+
+    QNetworkRequest req = request;
+    if (source && streaming.size >= 0) {
+        req.setHeader(QNetworkRequest::ContentLengthHeader, streaming.size);
+        req.setAttribute(QNetworkRequest::DoNotBufferUploadDataAttribute, true);
+    }
+    const bool tls = m_tlsSessions && req.url().scheme() == QLatin1String("https");
+    if (tls)
+        req.setSslConfiguration(resumingSsl(req.url(), req.sslConfiguration()));
+
+    QNetworkReply* reply = nullptr;
+    switch (verb) {
+    case Verb::Get:
+        reply = m_rest.get(req, this, std::move(onReply));
+        break;
+    case Verb::Post:
+        reply = source ? m_rest.post(req, source, this, std::move(onReply))
+                       : m_rest.post(req, data, this, std::move(onReply));
+        break;
+    case Verb::Put:
+        reply = source ? m_rest.put(req, source, this, std::move(onReply))
+                       : m_rest.put(req, data, this, std::move(onReply));
+        break;
+    case Verb::Patch:
+        reply = source ? m_rest.patch(req, source, this, std::move(onReply))
+                       : m_rest.patch(req, data, this, std::move(onReply));
+        break;
+    case Verb::Delete:
+        reply = m_rest.deleteResource(req, this, std::move(onReply));
+        break;
+    }
+
+    const auto it = m_pending.find(id);
+    if (it == m_pending.end()) return;
+    it->second.reply = reply;
+
+    if (tls) {
+        // At the end rather than on encrypted(): TLS 1.3 sends tickets after
+        // the handshake. Replies on a reused connection report its session.
+        connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+            if (m_tlsSessions) m_tlsSessions->store(reply->url(), reply->sslConfiguration());
+        });
+    }
+
+    if (it->second.streaming.onChunk) {
+        // Bounds what Qt reads off the socket while chunks are unconsumed
+        reply->setReadBufferSize(StreamWindow);
+        connect(reply, &QIODevice::readyRead, this, [this, id]() { pullChunks(id, false); });
+    }
+    if (it->second.streaming.onProgress) {
+        connect(reply, &QNetworkReply::uploadProgress, this, [this, id](qint64 sent, qint64 total) {
+            progress(id, true, sent, total);
+        });
+        connect(reply, &QNetworkReply::downloadProgress, this, [this, id](qint64 received, qint64 total) {
+            progress(id, false, received, total);
+        });
+    }
+}
+
+void HttpTransport::pullChunks(quint64 id, bool flush)
+{
+    // Re-looked up after every chunk: the hook may cancel the request
+    for (;;) {
+        const auto it = m_pending.find(id);
+        if (it == m_pending.end()) return;
+
+        Pending& p = it->second;
+        QNetworkReply* reply = p.reply;
+        if (!reply || reply->bytesAvailable() <= 0) return;
+
+        // Error bodies stay in the reply for the completion callback
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (status < 200 || status >= 300) return;
+
+        if (!flush && p.unacked >= StreamWindow) {
+            p.stalled = true;
+            return;
+        }
+        p.stalled = false;
+
+        const QByteArray chunk = reply->read(ChunkSize);
+        p.unacked += chunk.size();
+        p.streaming.onChunk(chunk);
+    }
+}
+
+void HttpTransport::progress(quint64 id, bool upload, qint64 done, qint64 total)
+{
+    const auto it = m_pending.find(id);
+    if (it != m_pending.end() && it->second.streaming.onProgress)
+        it->second.streaming.onProgress(upload, done, total);
+}
+
+HttpTransport::Pending& HttpTransport::emplace(quint64 id, Pending pending)
+{
+    if (const auto it = m_pending.find(id); it != m_pending.end()) {
+        it->second = std::move(pending);
+        return it->second;
+    }
+    if (m_spareNodes.empty())
+        return m_pending.emplace(id, std::move(pending)).first->second;
+
+    PendingMap::node_type node = std::move(m_spareNodes.back());
+    m_spareNodes.pop_back();
+    node.key() = id;
+    node.mapped() = std::move(pending);
+    return m_pending.insert(std::move(node)).position->second;
+}
+
+void HttpTransport::release(PendingMap::iterator it)
+{
+    // Only once the reply is finished or aborted, so it no longer reads it
+    if (it->second.pipe) it->second.pipe->deleteLater();
+
+    if (m_spareNodes.size() >= size_t(MaxSpareNodes)) {
+        m_pending.erase(it);
+        return;
+    }
+    PendingMap::node_type node = m_pending.extract(it);
+    node.mapped() = Pending{};   // drops the hooks' captures now
+    m_spareNodes.push_back(std::move(node));
+}
+
+QSslConfiguration HttpTransport::resumingSsl(const QUrl& url, QSslConfiguration ssl) const
+{
+    if (!m_tlsSessions) return ssl;
+
+    // Qt only keeps (and reports) the session when persistence is on
+    ssl.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    const QByteArray ticket = m_tlsSessions->ticket(url);
+    if (!ticket.isEmpty()) ssl.setSessionTicket(ticket);
+    return ssl;
+}
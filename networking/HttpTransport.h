@@ -0,0 +1,212 @@
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHttpHeaders>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QPointer>
+#include <QRestAccessManager>
+#include <QRestReply>
+#include <QSslConfiguration>
+#include <QTimer>
+#include <QUrl>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "TlsSessionCache.h"
+#include "UniqueFunction.h"
+
+// Everything a callback can read from a finished reply, detached from the
+// QNetworkReply so it can cross threads.
+struct ReplySnapshot
+{
+    QNetworkRequest request;
+    QNetworkAccessManager::Operation operation = QNetworkAccessManager::UnknownOperation;
+    QUrl url;
+    int httpStatus = 0;
+    QByteArray reasonPhrase;
+    QHttpHeaders headers;
+    QNetworkReply::NetworkError error = QNetworkReply::NoError;
+    QString errorString;
+    QByteArray body;
+
+    // Consumes the body of `reply`
+    static ReplySnapshot take(QRestReply& reply);
+};
+
+// Finished, read-only QNetworkReply replaying a ReplySnapshot
+class CompletedReply : public QNetworkReply
+{
+    Q_OBJECT
+
+public:
+    CompletedReply(ReplySnapshot snapshot, QObject* parent = nullptr);
+
+    void abort() override {}
+    qint64 bytesAvailable() const override;
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+
+private:
+    QByteArray m_body;
+    qsizetype  m_offset = 0;
+};
+
+// Read side of an upload whose source lives on another thread. The writer
+// feeds it a chunk whenever it emits drained().
+class StreamPipe : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit StreamPipe(QObject* parent = nullptr);
+
+    void append(const QByteArray& chunk);
+    void finish();   // no more chunks follow
+
+    bool isSequential() const override { return true; }
+    bool atEnd() const override;
+    qint64 bytesAvailable() const override;
+
+signals:
+    // Less than a chunk is buffered. The first chunk is asked for by
+    // whoever creates the pipe.
+    void drained();
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char*, qint64) override { return -1; }
+
+private:
+    qsizetype buffered() const { return m_buffer.size() - m_offset; }
+
+    QByteArray m_buffer;
+    qsizetype  m_offset = 0;
+    bool       m_finished = false;
+    bool       m_requested = true;
+};
+
+// Reads an upload source on its own thread and hands it on one chunk per
+// pump(), waiting for readyRead() when a sequential source runs dry.
+class StreamPump : public QObject
+{
+public:
+    using Feed = std::function<void(const QByteArray& chunk, bool last)>;
+
+    // `size` bounds what is read from `source`; -1 reads to its end
+    StreamPump(QIODevice* source, qint64 size, Feed feed, QObject* parent = nullptr);
+
+    void pump();
+
+private:
+    QPointer<QIODevice> m_source;
+    qint64 m_remaining;
+    Feed   m_feed;
+    bool   m_wanted = false;
+    bool   m_sourceFinished = false;
+    bool   m_done = false;
+};
+
+// Owns the QNetworkAccessManager an HttpClient sends through.
+//
+// It lives on the client's thread, or on a dedicated I/O thread when the
+// client enables one. Every member function must be called on the thread
+// it lives in; HttpClient reaches it through queued invocations then.
+class HttpTransport : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Verb { Get, Post, Put, Patch, Delete };
+
+    // HttpClient's reply handlers fit in place
+    using Completion = UniqueFunction<void(QRestReply&), 6 * sizeof(void*)>;
+
+    static constexpr qint64 ChunkSize = 64 * 1024;
+    // Streamed response bytes handed out but not yet consumed()
+    static constexpr qint64 StreamWindow = 16 * ChunkSize;
+
+    // Optional streamed parts of a request; the hooks run on this thread
+    struct Streaming
+    {
+        // Request body read from here instead of `data`. With `pipeSource`
+        // the transport reads a StreamPipe of its own instead, fed through
+        // feed() whenever onSourceDrained() runs.
+        QIODevice* source = nullptr;
+        bool pipeSource = false;
+        qint64 size = -1;   // Content-Length, when known
+        UniqueFunction<void()> onSourceDrained;
+
+        // A 2xx response body, in chunks instead of in the reply. Each
+        // chunk is acknowledged with consumed() once handled.
+        UniqueFunction<void(const QByteArray& chunk)> onChunk;
+
+        UniqueFunction<void(bool upload, qint64 done, qint64 total)> onProgress;
+    };
+
+    explicit HttpTransport(QObject* parent = nullptr);
+
+    // Sends `request` after `delayMs`. `done` runs on this thread with the
+    // reply unless `id` is cancelled first; one request per id at a time.
+    void send(quint64 id, Verb verb, const QNetworkRequest& request, const QByteArray& data,
+              int delayMs, Completion done, Streaming streaming = {});
+    void cancel(quint64 id);
+
+    // Aborts the reply of `id`; unlike cancel(), `done` still runs
+    void interrupt(quint64 id);
+
+    void feed(quint64 id, const QByteArray& chunk, bool last);
+    void consumed(quint64 id, qint64 bytes);
+
+    void warmUp(const QUrl& url);
+
+    // Warms `url` up again whenever nothing was sent for about `idleSec`,
+    // so a connection the server dropped while idle is back before the
+    // next request; 0 stops it
+    void keepWarm(const QUrl& url, int idleSec);
+
+    // HTTPS connections offer the cached session for their host and store
+    // the one they end up with; null turns it off
+    void setTlsSessionCache(TlsSessionCache* cache) { m_tlsSessions = cache; }
+
+private:
+    struct Pending
+    {
+        Completion done;
+        QPointer<QNetworkReply> reply;   // null while the delay runs
+        Streaming streaming;
+        StreamPipe* pipe = nullptr;
+        qint64 unacked = 0;
+        bool stalled = false;            // window full; resumed by consumed()
+    };
+    using PendingMap = std::unordered_map<quint64, Pending>;
+
+    // Released map nodes kept for later requests, so a steady request rate
+    // does not allocate one per request
+    static constexpr int MaxSpareNodes = 64;
+
+    Pending& emplace(quint64 id, Pending pending);
+    void dispatch(quint64 id, Verb verb, const QNetworkRequest& request, const QByteArray& data);
+    void pullChunks(quint64 id, bool flush);
+    void progress(quint64 id, bool upload, qint64 done, qint64 total);
+    void release(PendingMap::iterator it);
+    QSslConfiguration resumingSsl(const QUrl& url, QSslConfiguration ssl) const;
+
+    QNetworkAccessManager m_nam;
+    QRestAccessManager    m_rest;
+
+    QUrl          m_warmUrl;
+    QTimer        m_keepWarm;
+    int           m_keepWarmMs = 0;
+    QElapsedTimer m_lastSend;
+
+    TlsSessionCache* m_tlsSessions = nullptr;
+
+    PendingMap m_pending;
+    std::vector<PendingMap::node_type> m_spareNodes;
+};
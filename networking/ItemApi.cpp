@@ -1,14 +1,13 @@
 #include "ItemApi.h"
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
 #include <QDebug>
+#include <memory>
 #include "ApiEndpoints.h"
+#include "serialization/JsonArrayStream.h"
 
 ItemApi::ItemApi(HttpClient* client, QObject* parent)
     : BaseApi(client, parent) {}
 
-void ItemApi::fetchAll(std::function<void(const QList<Item>&)> successCb,
+void ItemApi::fetchAll(UniqueFunction<void(ItemStore&&)> successCb,
                        ErrorCb errorCb)
 {
     if (!ensureClient(errorCb)) return;
@@ -17,38 +16,38 @@ void ItemApi::fetchAll(std::function<void(const QList<Item>&)> successCb,
     qDebug().noquote() << "[ItemApi] GET" << url;
 
     client()->get(url, [
+        this,
         successCb = std::move(successCb),
         errorCb   = std::move(errorCb)
     ](QRestReply& reply) mutable {
         qDebug().noquote() << "[ItemApi] ←" << reply.httpStatus() << "GET /api/items";
 
-        expectArray(reply, errorCb, [&](const QJsonArray& arr) {
-            if (!successCb) return;
-            QList<Item> items;
-            items.reserve(arr.size());
-            for (const QJsonValue& val : arr) {
-                Item item;
-                item.fromJson(val.toObject());
-                items.append(item);
-            }
-            qDebug().noquote() << "[ItemApi] ← parsed" << items.size() << "items";
-            successCb(items);
+        expectArrayInBackground(reply, errorCb, this, [](JsonReader& reader) {
+            ItemStore batch = decodeItems(reader);
+            qDebug().noquote() << "[ItemApi] ← parsed" << batch.size() << "items";
+            return batch;
+        }, [successCb = std::move(successCb)](ItemStore&& batch) mutable {
+            if (successCb) successCb(std::move(batch));
         });
     });
 }
 
 void ItemApi::create(const QString& name,
                      const QString& status,
-                     std::function<void(const Item&)> successCb,
+                     UniqueFunction<void(Item&&)> successCb,
                      ErrorCb errorCb)
 {
     if (!ensureClient(errorCb)) return;
 
-    QJsonObject body;
-    body["name"]   = name;
-    body["status"] = status;
+    QByteArray payload;
+    JsonWriter body(payload);
+    body.beginObject();
+    body.key("name");
+    body.string(name);
+    body.key("status");
+    body.string(status);
+    body.endObject();
 
-    const QByteArray payload = QJsonDocument(body).toJson(QJsonDocument::Compact);
     const QString url = ApiEndpoints::Items();
     qDebug().noquote() << "[ItemApi] POST" << url;
     qDebug().noquote() << "[ItemApi] → body:" << payload;
@@ -59,29 +58,30 @@ void ItemApi::create(const QString& name,
     ](QRestReply& reply) mutable {
         qDebug().noquote() << "[ItemApi] ←" << reply.httpStatus() << "POST /api/items";
 
-        expectObject(reply, errorCb, [&](const QJsonObject& obj) {
+        expectEntity<Item>(reply, errorCb, [&](Item&& item) {
             if (!successCb) return;
-            Item item;
-            item.fromJson(obj);
             qDebug().noquote() << "[ItemApi] ← created item id=" << item.id
                                << "name=" << item.name
                                << "status=" << item.status;
-            successCb(item);
+            successCb(std::move(item));
         });
     });
 }
 
 void ItemApi::update(const QString& id,
                      const QString& name,
-                     std::function<void(const Item&)> successCb,
+                     UniqueFunction<void(Item&&)> successCb,
                      ErrorCb errorCb)
 {
     if (!ensureClient(errorCb)) return;
 
-    QJsonObject body;
-    body["name"] = name;
+    QByteArray payload;
+    JsonWriter body(payload);
+    body.beginObject();
+    body.key("name");
+    body.string(name);
+    body.endObject();
 
-    const QByteArray payload = QJsonDocument(body).toJson(QJsonDocument::Compact);
     const QString url = ApiEndpoints::Items() + "/" + id;
     qDebug().noquote() << "[ItemApi] PUT" << url;
     qDebug().noquote() << "[ItemApi] → body:" << payload;
@@ -92,20 +92,18 @@ void ItemApi::update(const QString& id,
     ](QRestReply& reply) mutable {
         qDebug().noquote() << "[ItemApi] ←" << reply.httpStatus() << "PUT /api/items/:id";
 
-        expectObject(reply, errorCb, [&](const QJsonObject& obj) {
+        expectEntity<Item>(reply, errorCb, [&](Item&& item) {
             if (!successCb) return;
-            Item item;
-            item.fromJson(obj);
             qDebug().noquote() << "[ItemApi] ← updated item id=" << item.id
                                << "name=" << item.name
                                << "status=" << item.status;
-            successCb(item);
+            successCb(std::move(item));
         });
     });
 }
 
 void ItemApi::remove(const QString& id,
-                     std::function<void()> successCb,
+                     UniqueFunction<void()> successCb,
                      ErrorCb errorCb)
 {
     if (!ensureClient(errorCb)) return;
@@ -127,3 +125,94 @@ void ItemApi::remove(const QString& id,
         if (successCb) successCb();
     });
 }
+
+void ItemApi::exportTo(QIODevice* sink,
+                       UniqueFunction<void(qint64 count)> successCb,
+                       ErrorCb errorCb)
+{
+    if (!ensureClient(errorCb)) return;
+
+    const QString url = ApiEndpoints::Items();
+    qDebug().noquote() << "[ItemApi] GET" << url << "→ NDJSON";
+
+    // Shared by the chunk handler and the completion; each element of the
+    // list is re-encoded onto a single line as soon as it is complete
+    struct Export {
+        QPointer<QIODevice>     sink;
+        RequestTicket           request;
+        JsonArrayStream         splitter;
+        Item                    item;
+        QByteArray              line;
+        qint64                  count = 0;
+        bool                    failed = false;
+        UniqueFunction<void(qint64)> successCb;
+        ErrorCb                 errorCb;
+    };
+    auto state = std::make_shared<Export>();
+    state->sink = sink;
+    state->successCb = std::move(successCb);
+    state->errorCb = std::move(errorCb);
+
+    auto onChunk = [state](const QByteArray& chunk) {
+        if (state->failed) return;
+
+        QString failure;
+        state->splitter.feed(chunk, [&](QByteArrayView element) {
+            JsonCodec::reset(state->item);
+            if (!JsonCodec::decode(element, state->item)) {
+                failure = "Invalid item in list";
+                return false;
+            }
+            state->line.resize(0);
+            JsonCodec::encode(state->item, state->line);
+            state->line.append('\n');
+            if (!state->sink || state->sink->write(state->line) != state->line.size()) {
+                failure = "Export write failed: "
+                        + (state->sink ? state->sink->errorString() : QStringLiteral("device deleted"));
+                return false;
+            }
+            ++state->count;
+            return true;
+        });
+        if (!state->splitter.hasError()) return;
+
+        state->failed = true;
+        qWarning().noquote() << "[ItemApi] export stopped after" << state->count << "items:"
+                             << (failure.isEmpty() ? QStringLiteral("Invalid JSON response") : failure);
+        state->request.abort();
+        emitError(state->errorCb, ErrorResult{ 0, failure.isEmpty() ? QStringLiteral("Invalid JSON response")
+                                                                    : failure, nullptr });
+    };
+
+    RequestHandle* handle = client()->get(url, std::move(onChunk), [state](QRestReply& reply) {
+        qDebug().noquote() << "[ItemApi] ←" << reply.httpStatus() << "GET /api/items (NDJSON)";
+
+        if (state->failed) return;
+        if (!reply.isSuccess()) {
+            emitError(state->errorCb, fromReply(reply));
+            return;
+        }
+        if (!state->splitter.finished()) {
+            emitError(state->errorCb, fromReply(reply, "Truncated item list"));
+            return;
+        }
+        qDebug().noquote() << "[ItemApi] ← exported" << state->count << "items";
+        if (state->successCb) state->successCb(state->count);
+    });
+    state->request = RequestTicket(handle);
+}
+
+ItemStore ItemApi::decodeItems(JsonReader& reader)
+{
+    // One scratch Item is reused for every element; its strings keep their
+    // capacity and the store copies the characters into its pools
+    ItemStore batch;
+    Item item;
+    JsonCodec::readArray(reader, [&](JsonReader& r) {
+        JsonCodec::reset(item);
+        if (!JsonCodec::readValue(r, item, JsonCodec::NoFlags)) return false;
+        batch.append(item);
+        return true;
+    });
+    return batch;
+}
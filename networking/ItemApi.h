@@ -1,10 +1,11 @@
 #ifndef ITEMAPI_H
 #define ITEMAPI_H
 
-#include <functional>
-#include <QList>
+#include <QIODevice>
 #include "BaseApi.h"
+#include "UniqueFunction.h"
 #include "entities/Item.h"
+#include "entities/ItemStore.h"
 
 class ItemApi : public BaseApi
 {
@@ -13,22 +14,35 @@ class ItemApi : public BaseApi
 public:
     explicit ItemApi(HttpClient* client, QObject* parent = nullptr);
 
-    void fetchAll(std::function<void(const QList<Item>&)> successCb,
+    // Decodes off the calling thread; successCb receives a ready-to-insert
+    // batch on the thread ItemApi lives in. Callbacks are move-only and get
+    // their results by rvalue, so nothing on the way is copied.
+    void fetchAll(UniqueFunction<void(ItemStore&&)> successCb,
                   ErrorCb errorCb);
 
     void create(const QString& name,
                 const QString& status,
-                std::function<void(const Item&)> successCb,
+                UniqueFunction<void(Item&&)> successCb,
                 ErrorCb errorCb);
 
     void update(const QString& id,
                 const QString& name,
-                std::function<void(const Item&)> successCb,
+                UniqueFunction<void(Item&&)> successCb,
                 ErrorCb errorCb);
 
     void remove(const QString& id,
-                std::function<void()> successCb,
+                UniqueFunction<void()> successCb,
                 ErrorCb errorCb);
+
+    // Streams every item to `sink` as newline-delimited JSON, one object
+    // per line, without holding the list in memory. successCb gets the
+    // number of items written.
+    void exportTo(QIODevice* sink,
+                  UniqueFunction<void(qint64 count)> successCb,
+                  ErrorCb errorCb);
+
+    // Decodes a GET /api/items array body; what fetchAll() runs off-thread
+    static ItemStore decodeItems(JsonReader& reader);
 };
 
 #endif // ITEMAPI_H
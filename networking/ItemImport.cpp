@@ -0,0 +1,273 @@
+#include "ItemImport.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QSaveFile>
+#include "ItemApi.h"
+
+namespace {
+
+constexpr qsizetype MaxNameLength = 200;
+constexpr qint64 MaxRejectWarnings = 20;
+
+const char* const Statuses[] = { "active", "inactive", "maintenance" };
+
+} // namespace
+
+ItemImport::ItemImport(ItemApi* api, const QString& path, const ImportOptions& options, QObject* parent)
+    : QObject(parent)
+    , m_api(api)
+    , m_options(options)
+    , m_file(path)
+    , m_checkpointPath(options.checkpointPath.isEmpty() ? path + ".checkpoint" : options.checkpointPath)
+{
+    m_options.batchSize = qMax(1, m_options.batchSize);
+    m_options.concurrency = qMax(1, m_options.concurrency);
+}
+
+void ItemImport::start()
+{
+    if (m_running) return;
+    if (!m_api) {
+        emit failed("ItemApi is null");
+        return;
+    }
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        emit failed("Cannot open " + m_file.fileName() + ": " + m_file.errorString());
+        return;
+    }
+
+    m_running = true;
+    loadCheckpoint();
+    qDebug().noquote() << "[ItemImport] importing" << m_file.fileName() << "from line" << m_line + 1;
+    emit progress(m_checkpoint.offset, m_file.size());
+    pump();
+}
+
+void ItemImport::cancel()
+{
+    if (!m_running || m_stopping) return;
+    qDebug().noquote() << "[ItemImport] cancelling," << m_inFlight << "creates in flight";
+    m_stopping = true;
+    pump();
+}
+
+void ItemImport::readBatch()
+{
+    // Parse and validate; rejected lines still count towards the batch so
+    // the checkpoint moves past them
+    Batch batch;
+    batch.items.reserve(size_t(m_options.batchSize));
+
+    while (batch.items.size() < size_t(m_options.batchSize)) {
+        if (m_file.atEnd()) {
+            m_eof = true;
+            break;
+        }
+
+        QByteArray line = m_file.readLine(m_options.maxLineBytes + 1);
+        ++m_line;
+        if (!line.endsWith('\n') && !m_file.atEnd()) {
+            // Skip the rest of an overlong line without buffering it
+            while (!m_file.atEnd() && !m_file.readLine(m_options.maxLineBytes + 1).endsWith('\n')) {}
+            reject(batch, "line too long");
+            continue;
+        }
+
+        const QByteArrayView json = QByteArrayView(line).trimmed();
+        if (json.isEmpty()) continue;
+
+        Item item;
+        QString reason = "invalid JSON object";
+        if (JsonCodec::decode(json, item) && validate(item, reason)) {
+            batch.items.push_back(std::move(item));
+            continue;
+        }
+        reject(batch, reason);
+    }
+
+    batch.endOffset = m_file.pos();
+    batch.endLine = m_line;
+    m_batches.push_back(std::move(batch));
+}
+
+bool ItemImport::validate(Item& item, QString& reason) const
+{
+    item.name = item.name.trimmed();
+    if (item.name.isEmpty()) {
+        reason = "missing name";
+        return false;
+    }
+    if (item.name.size() > MaxNameLength) {
+        reason = "name longer than " + QString::number(MaxNameLength);
+        return false;
+    }
+
+    if (item.status.isEmpty()) item.status = QStringLiteral("active");
+    for (const char* status : Statuses) {
+        if (item.status == QLatin1StringView(status)) return true;
+    }
+    reason = "unknown status \"" + item.status + '"';
+    return false;
+}
+
+void ItemImport::reject(Batch& batch, const QString& reason)
+{
+    ++batch.rejected;
+    if (++m_rejected <= MaxRejectWarnings)
+        qWarning().noquote() << "[ItemImport] line" << m_line << "rejected:" << reason;
+}
+
+ItemImport::Batch* ItemImport::nextToSend()
+{
+    // Bounds how far reading runs ahead of the uploads
+    const size_t maxBatches = 2 + size_t(m_options.concurrency / m_options.batchSize);
+
+    for (;;) {
+        for (Batch& batch : m_batches) {
+            if (batch.next < batch.items.size()) return &batch;
+        }
+        if (m_eof || m_batches.size() >= maxBatches) return nullptr;
+
+        readBatch();
+        // A batch of rejected lines only is done right away
+        advanceCheckpoint();
+    }
+}
+
+void ItemImport::pump()
+{
+    while (!m_stopping && m_inFlight < m_options.concurrency) {
+        Batch* batch = nextToSend();
+        if (!batch) break;
+        send(batch);
+    }
+
+    if (m_inFlight == 0 && (m_stopping || (m_eof && m_batches.empty())))
+        finish();
+}
+
+void ItemImport::send(Batch* batch)
+{
+    const Item& item = batch->items[batch->next++];
+    ++batch->outstanding;
+    ++m_inFlight;
+
+    // Batches stay put in the deque until their last create is back
+    const QPointer<ItemImport> guard(this);
+    m_api->create(item.name, item.status, [guard, batch](Item&&) {
+        if (guard) guard->completed(batch, Created);
+    }, [guard, batch](const ErrorResult& err) {
+        if (!guard) return;
+        const bool rejected = err.status >= 400 && err.status < 500 && err.status != 401 && err.status != 429;
+        guard->completed(batch, rejected ? Rejected : Failed, err.message);
+    });
+}
+
+void ItemImport::completed(Batch* batch, Outcome outcome, const QString& message)
+{
+    --batch->outstanding;
+    --m_inFlight;
+
+    switch (outcome) {
+    case Created:
+        ++batch->imported;
+        ++m_imported;
+        break;
+    case Rejected:
+        ++batch->rejected;
+        if (++m_rejected <= MaxRejectWarnings)
+            qWarning().noquote() << "[ItemImport] server rejected an item:" << message;
+        break;
+    case Failed:
+        batch->failed = true;
+        if (m_failure.isEmpty()) {
+            qWarning().noquote() << "[ItemImport] create failed, stopping:" << message;
+            m_failure = message;
+        }
+        m_stopping = true;
+        break;
+    }
+
+    advanceCheckpoint();
+    pump();
+}
+
+void ItemImport::advanceCheckpoint()
+{
+    bool advanced = false;
+    while (!m_batches.empty() && m_batches.front().done() && !m_batches.front().failed) {
+        const Batch& batch = m_batches.front();
+        m_checkpoint.offset = batch.endOffset;
+        m_checkpoint.line = batch.endLine;
+        m_checkpoint.imported += batch.imported;
+        m_checkpoint.rejected += batch.rejected;
+        m_batches.pop_front();
+        advanced = true;
+    }
+    if (!advanced) return;
+
+    saveCheckpoint();
+    emit progress(m_checkpoint.offset, m_file.size());
+}
+
+void ItemImport::loadCheckpoint()
+{
+    const QFileInfo info(m_file);
+    m_checkpoint = ImportCheckpoint{};
+    m_checkpoint.file = info.absoluteFilePath();
+    m_checkpoint.fileSize = info.size();
+    m_checkpoint.modifiedMs = info.lastModified().toMSecsSinceEpoch();
+
+    QFile file(m_checkpointPath);
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    ImportCheckpoint saved;
+    if (!JsonCodec::decode(file.readAll(), saved)
+        || saved.file != m_checkpoint.file
+        || saved.fileSize != m_checkpoint.fileSize
+        || saved.modifiedMs != m_checkpoint.modifiedMs
+        || saved.offset < 0 || saved.offset > saved.fileSize) {
+        qWarning().noquote() << "[ItemImport] ignoring checkpoint" << m_checkpointPath
+                             << "(file changed or checkpoint invalid)";
+        return;
+    }
+
+    m_checkpoint = saved;
+    m_file.seek(saved.offset);
+    m_line = saved.line;
+    m_imported = saved.imported;
+    m_rejected = saved.rejected;
+    qDebug().noquote() << "[ItemImport] resuming after line" << m_line << "(" << m_imported << "imported )";
+}
+
+void ItemImport::saveCheckpoint()
+{
+    QSaveFile file(m_checkpointPath);
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(JsonCodec::encode(m_checkpoint)) < 0
+        || !file.commit()) {
+        qWarning().noquote() << "[ItemImport] cannot save checkpoint" << m_checkpointPath
+                             << ":" << file.errorString();
+    }
+}
+
+void ItemImport::finish()
+{
+    if (!m_running) return;
+    m_running = false;
+    m_file.close();
+
+    if (!m_failure.isEmpty()) {
+        emit failed(m_failure);
+        return;
+    }
+    if (m_stopping) {
+        emit failed("Import cancelled");
+        return;
+    }
+
+    QFile::remove(m_checkpointPath);
+    qDebug().noquote() << "[ItemImport] done:" << m_imported << "imported," << m_rejected << "rejected";
+    emit finished(m_imported, m_rejected);
+}
@@ -0,0 +1,127 @@
+#ifndef ITEMIMPORT_H
+#define ITEMIMPORT_H
+
+#include <QFile>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <deque>
+#include <vector>
+#include "entities/Item.h"
+#include "serialization/JsonCodec.h"
+
+class ItemApi;
+
+struct ImportOptions
+{
+    int     batchSize = 100;          // items per checkpoint
+    int     concurrency = 4;          // creates in flight
+    qint64  maxLineBytes = 64 * 1024;
+    QString checkpointPath;           // "<file>.checkpoint" when empty
+};
+
+// Where an interrupted import of one file resumes
+struct ImportCheckpoint
+{
+    QString file;
+    qint64  fileSize = 0;
+    qint64  modifiedMs = 0;
+    qint64  offset = 0;     // first byte not covered yet
+    qint64  line = 0;
+    qint64  imported = 0;
+    qint64  rejected = 0;
+};
+
+template<>
+struct JsonCodec::Fields<ImportCheckpoint> {
+    static constexpr auto list = std::tuple{
+        JsonCodec::field("file",       &ImportCheckpoint::file),
+        JsonCodec::field("fileSize",   &ImportCheckpoint::fileSize),
+        JsonCodec::field("modifiedMs", &ImportCheckpoint::modifiedMs),
+        JsonCodec::field("offset",     &ImportCheckpoint::offset),
+        JsonCodec::field("line",       &ImportCheckpoint::line),
+        JsonCodec::field("imported",   &ImportCheckpoint::imported),
+        JsonCodec::field("rejected",   &ImportCheckpoint::rejected),
+    };
+};
+
+// Creates the items of a newline-delimited JSON file through a bounded
+// pipeline: lines are parsed and validated into batches, and the items of
+// the batches in hand are uploaded with at most `concurrency` creates
+// outstanding. Only a few batches are held at a time, whatever the size
+// of the file.
+//
+// Once every item of a batch is through, a checkpoint is saved; start()
+// on the same, unchanged file resumes after the last one. Items created
+// past the checkpoint before an import stopped are created again then.
+// Lines that do not parse or validate, and items the server answers with
+// a 4xx, are counted as rejected and skipped.
+class ItemImport : public QObject
+{
+    Q_OBJECT
+
+public:
+    ItemImport(ItemApi* api, const QString& path, const ImportOptions& options = {},
+               QObject* parent = nullptr);
+
+    void start();
+
+    // Sends nothing more; failed() follows once the creates in flight are
+    // back. The checkpoint is kept.
+    void cancel();
+
+    qint64 imported() const { return m_imported; }
+    qint64 rejected() const { return m_rejected; }
+
+signals:
+    void progress(qint64 bytesDone, qint64 bytesTotal);
+    void finished(qint64 imported, qint64 rejected);
+    void failed(const QString& message);
+
+private:
+    struct Batch
+    {
+        std::vector<Item> items;
+        size_t  next = 0;          // first item not sent yet
+        int     outstanding = 0;
+        qint64  imported = 0;
+        qint64  rejected = 0;
+        qint64  endOffset = 0;
+        qint64  endLine = 0;
+        bool    failed = false;
+
+        bool done() const { return next == items.size() && outstanding == 0; }
+    };
+
+    enum Outcome { Created, Rejected, Failed };
+
+    void readBatch();
+    bool validate(Item& item, QString& reason) const;
+    void reject(Batch& batch, const QString& reason);
+    Batch* nextToSend();
+    void pump();
+    void send(Batch* batch);
+    void completed(Batch* batch, Outcome outcome, const QString& message = {});
+    void advanceCheckpoint();
+    void loadCheckpoint();
+    void saveCheckpoint();
+    void finish();
+
+    QPointer<ItemApi>   m_api;
+    ImportOptions       m_options;
+    QFile               m_file;
+    QString             m_checkpointPath;
+    ImportCheckpoint    m_checkpoint;
+
+    std::deque<Batch>   m_batches;   // in file order; the front is checkpointed next
+    qint64              m_line = 0;
+    int                 m_inFlight = 0;
+    qint64              m_imported = 0;
+    qint64              m_rejected = 0;
+    bool                m_eof = false;
+    bool                m_running = false;
+    bool                m_stopping = false;
+    QString             m_failure;
+};
+
+#endif // ITEMIMPORT_H
@@ -0,0 +1,200 @@
+#include "RateLimiter.h"
+#include <QDateTime>
+#include <QDebug>
+#include <cmath>
+
+namespace {
+
+// Non-negative integer header value; -1 when missing or malformed
+qint64 headerNumber(const QHttpHeaders& headers, QAnyStringView name)
+{
+    bool ok = false;
+    const qint64 value = headers.value(name).toByteArray().trimmed().toLongLong(&ok);
+    return ok && value >= 0 ? value : -1;
+}
+
+} // namespace
+
+RateLimiter::RateLimiter(QObject* parent)
+    : QObject(parent)
+    , m_timer(this)
+{
+    m_clock.start();
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &RateLimiter::drain);
+}
+
+void RateLimiter::setLimits(double ratePerSec, int burst)
+{
+    m_rate = qMax(ratePerSec, 0.01);
+    m_burst = qMax(burst, 1);
+    m_timer.start(0);
+}
+
+RateLimiter::HostKey RateLimiter::keyOf(const QUrl& url)
+{
+    // QUrl already lower-cases hosts; nothing is concatenated per request
+    return { url.host(), url.port(url.scheme() == QLatin1String("https") ? 443 : 80) };
+}
+
+RateLimiter::Bucket& RateLimiter::bucket(const HostKey& host, qint64 now)
+{
+    const auto [it, inserted] = m_buckets.try_emplace(host);
+    if (inserted) {
+        it->second.tokens = m_burst;
+        it->second.refilledAt = now;
+    }
+    return it->second;
+}
+
+double RateLimiter::rateOf(const Bucket& b, qint64 now) const
+{
+    return now < b.serverRateUntil ? qMin(m_rate, b.serverRate) : m_rate;
+}
+
+void RateLimiter::refill(Bucket& b, qint64 now) const
+{
+    // refilledAt lies ahead while a pause runs
+    if (now <= b.refilledAt) return;
+    b.tokens = qMin<double>(m_burst, b.tokens + (now - b.refilledAt) / 1000.0 * rateOf(b, now));
+    b.refilledAt = now;
+}
+
+bool RateLimiter::available(const Bucket& b, qint64 now)
+{
+    return b.waiters.empty() && now >= b.pausedUntil && b.tokens >= 1;
+}
+
+bool RateLimiter::tryAcquire(const QUrl& url)
+{
+    const qint64 now = m_clock.elapsed();
+    Bucket& b = bucket(keyOf(url), now);
+    refill(b, now);
+
+    if (!available(b, now)) return false;
+    b.tokens -= 1;
+    return true;
+}
+
+void RateLimiter::acquire(const QUrl& url, int delayMs, Release release)
+{
+    const qint64 now = m_clock.elapsed();
+    Bucket& b = bucket(keyOf(url), now);
+    refill(b, now);
+
+    if (delayMs <= 0 && available(b, now)) {
+        if (release()) b.tokens -= 1;
+        return;
+    }
+    b.waiters.push_back(Waiter{ now + qMax(delayMs, 0), std::move(release) });
+    m_timer.start(0);
+}
+
+void RateLimiter::observe(const QUrl& url, int httpStatus, const QHttpHeaders& headers)
+{
+    const HostKey host = keyOf(url);
+    const qint64 now = m_clock.elapsed();
+    Bucket& b = bucket(host, now);
+
+    if (httpStatus == 429 || httpStatus == 503) {
+        const qint64 retryAfter = retryAfterMs(headers);
+        if (retryAfter >= 0)
+            pause(host, b, now, retryAfter);
+        else if (httpStatus == 429)
+            pause(host, b, now, 1000);   // throttled without a hint
+    }
+
+    const qint64 remaining = headerNumber(headers, "RateLimit-Remaining");
+    // Clamped before it is turned into milliseconds
+    const qint64 reset = qMin(headerNumber(headers, "RateLimit-Reset"), MaxPauseMs / 1000);
+    if (remaining < 0 || reset < 0) return;
+
+    if (remaining == 0) {
+        pause(host, b, now, reset * 1000);
+    } else if (reset > 0) {
+        refill(b, now);
+        b.serverRate = double(remaining) / double(reset);
+        b.serverRateUntil = now + reset * 1000;
+        b.tokens = qMin(b.tokens, double(remaining));
+    }
+}
+
+qint64 RateLimiter::retryAfterMs(const QHttpHeaders& headers)
+{
+    const QByteArray value = headers.value("Retry-After").toByteArray().trimmed();
+    if (value.isEmpty()) return -1;
+
+    bool ok = false;
+    const qint64 seconds = value.toLongLong(&ok);
+    // Clamped before the conversion, so a huge value cannot overflow
+    if (ok) return seconds >= 0 ? qMin(seconds, MaxPauseMs / 1000) * 1000 : -1;
+
+    const QDateTime at = QDateTime::fromString(QString::fromLatin1(value), Qt::RFC2822Date);
+    if (!at.isValid()) return -1;
+    return qBound<qint64>(0, QDateTime::currentDateTimeUtc().msecsTo(at), MaxPauseMs);
+}
+
+void RateLimiter::pause(const HostKey& host, Bucket& b, qint64 now, qint64 ms)
+{
+    const qint64 until = now + qMin(ms, MaxPauseMs);
+    if (until <= b.pausedUntil) return;
+
+    qDebug().noquote() << "[NETWORK] Throttled:" << host.first + u':' + QString::number(host.second)
+                       << "paused for" << (until - now) << "ms";
+    b.pausedUntil = until;
+    b.tokens = 0;
+    b.refilledAt = until;
+    m_timer.start(0);
+}
+
+void RateLimiter::drain()
+{
+    qint64 wake = -1;
+    const auto wakeAt = [&wake](qint64 at) {
+        if (wake < 0 || at < wake) wake = at;
+    };
+
+    for (auto& entry : m_buckets) {
+        Bucket& b = entry.second;
+        for (;;) {
+            const qint64 now = m_clock.elapsed();
+            refill(b, now);
+            if (b.waiters.empty()) break;
+
+            if (now < b.pausedUntil) {
+                wakeAt(b.pausedUntil);
+                break;
+            }
+
+            // The first waiter whose delay is over; later ones overtake
+            // a retry that is still backing off
+            auto ready = b.waiters.end();
+            qint64 earliest = -1;
+            for (auto it = b.waiters.begin(); it != b.waiters.end(); ++it) {
+                if (it->notBefore <= now) {
+                    ready = it;
+                    break;
+                }
+                if (earliest < 0 || it->notBefore < earliest) earliest = it->notBefore;
+            }
+            if (ready == b.waiters.end()) {
+                wakeAt(earliest);
+                break;
+            }
+
+            if (b.tokens < 1) {
+                const double rate = rateOf(b, now);
+                wakeAt(now + qint64(std::ceil((1 - b.tokens) / rate * 1000)));
+                break;
+            }
+
+            // Taken out first: releasing may queue further waiters
+            Release release = std::move(ready->release);
+            b.waiters.erase(ready);
+            if (release()) b.tokens -= 1;
+        }
+    }
+
+    if (wake >= 0)
+        m_timer.start(int(qMax<qint64>(0, wake - m_clock.elapsed())));
+}
@@ -0,0 +1,88 @@
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <QElapsedTimer>
+#include <QHttpHeaders>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QUrl>
+#include <deque>
+#include <map>
+#include <utility>
+#include "UniqueFunction.h"
+
+// Per-host token buckets in front of HttpClient's dispatch.
+//
+// Each host ("host:port") gets `rate` requests per second with bursts of up
+// to `burst`. The server can tighten that: a Retry-After on 429/503, or
+// RateLimit-Remaining: 0, pauses the whole host; a non-zero
+// RateLimit-Remaining over RateLimit-Reset seconds lowers its rate until
+// the reset. After a pause the bucket starts empty, so queued requests
+// trickle out at the rate instead of all at once.
+//
+// Lives on the thread of the HttpClients sharing it.
+class RateLimiter : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Returns false when it no longer sends anything, so it takes no token
+    using Release = UniqueFunction<bool(), 6 * sizeof(void*)>;
+
+    // Longest pause a server can impose
+    static constexpr qint64 MaxPauseMs = 10 * 60 * 1000;
+
+    explicit RateLimiter(QObject* parent = nullptr);
+
+    void setLimits(double ratePerSec, int burst);
+
+    // Takes a token of `url`'s host if one is free and nobody waits for it
+    bool tryAcquire(const QUrl& url);
+
+    // Runs `release` once `url`'s host has a token to spare, no earlier
+    // than `delayMs` from now. Waiters of a host are released in order.
+    void acquire(const QUrl& url, int delayMs, Release release);
+
+    // Adapts to the throttling headers of a response from `url`
+    void observe(const QUrl& url, int httpStatus, const QHttpHeaders& headers);
+
+    // Retry-After (seconds or HTTP date) in milliseconds, at most
+    // MaxPauseMs; -1 without one
+    static qint64 retryAfterMs(const QHttpHeaders& headers);
+
+private:
+    struct Waiter {
+        qint64 notBefore;
+        Release release;
+    };
+
+    struct Bucket {
+        double tokens = 0;
+        qint64 refilledAt = 0;
+        qint64 pausedUntil = 0;
+        double serverRate = 0;        // from RateLimit-*, until serverRateUntil
+        qint64 serverRateUntil = 0;
+        std::deque<Waiter> waiters;
+    };
+
+    using HostKey = std::pair<QString, int>;
+
+    static HostKey keyOf(const QUrl& url);
+    static bool available(const Bucket& b, qint64 now);
+
+    Bucket& bucket(const HostKey& host, qint64 now);
+    double rateOf(const Bucket& b, qint64 now) const;
+    void refill(Bucket& b, qint64 now) const;
+    void pause(const HostKey& host, Bucket& b, qint64 now, qint64 ms);
+    void drain();
+
+    double m_rate = 50;
+    int    m_burst = 20;
+
+    QElapsedTimer m_clock;
+    QTimer        m_timer;
+    std::map<HostKey, Bucket> m_buckets;
+};
+
+#endif // RATELIMITER_H
@@ -0,0 +1,80 @@
+#include "TlsSessionCache.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QMutexLocker>
+#include <iterator>
+
+TlsSessionCache::TlsSessionCache(QObject* parent)
+    : QObject(parent)
+{
+}
+
+QString TlsSessionCache::peerOf(const QUrl& url)
+{
+    return url.host().toLower() + u':' + QString::number(url.port(443));
+}
+
+QByteArray TlsSessionCache::ticket(const QUrl& url) const
+{
+    QMutexLocker lock(&m_mutex);
+    const auto it = m_entries.constFind(peerOf(url));
+    if (it == m_entries.cend() || it->expiresAt <= QDateTime::currentSecsSinceEpoch())
+        return {};
+    return it->ticket;
+}
+
+void TlsSessionCache::store(const QUrl& url, const QSslConfiguration& ssl)
+{
+    const QByteArray ticket = ssl.sessionTicket();
+    if (ticket.isEmpty()) return;
+
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    const int hint = ssl.sessionTicketLifeTimeHint();
+    const qint64 expiresAt = now + (hint > 0 ? hint : DefaultLifetimeSec);
+    const QString peer = peerOf(url);
+    {
+        QMutexLocker lock(&m_mutex);
+        Entry& e = m_entries[peer];
+        if (e.ticket == ticket) return;   // resumed with what we offered
+        e = Entry{ ticket, expiresAt };
+
+        // Drop expired sessions, then the ones closest to expiring
+        for (auto it = m_entries.begin(); it != m_entries.end();)
+            it = it->expiresAt <= now ? m_entries.erase(it) : std::next(it);
+        while (m_entries.size() > MaxSessions) {
+            auto oldest = m_entries.begin();
+            for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+                if (it->expiresAt < oldest->expiresAt) oldest = it;
+            }
+            m_entries.erase(oldest);
+        }
+    }
+    qDebug().noquote() << "[NETWORK] TLS session stored for" << peer;
+    emit changed();
+}
+
+QList<TlsSession> TlsSessionCache::sessions() const
+{
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    QList<TlsSession> out;
+
+    QMutexLocker lock(&m_mutex);
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        if (it->expiresAt > now)
+            out.append(TlsSession{ it.key(), QString::fromLatin1(it->ticket.toBase64()), it->expiresAt });
+    }
+    return out;
+}
+
+void TlsSessionCache::restore(const QList<TlsSession>& sessions)
+{
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+
+    QMutexLocker lock(&m_mutex);
+    for (const TlsSession& s : sessions) {
+        if (s.peer.isEmpty() || s.expiresAt <= now) continue;
+        const QByteArray ticket = QByteArray::fromBase64(s.ticket.toLatin1());
+        if (!ticket.isEmpty())
+            m_entries.insert(s.peer, Entry{ ticket, s.expiresAt });
+    }
+}
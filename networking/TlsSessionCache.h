@@ -0,0 +1,56 @@
+#ifndef TLSSESSIONCACHE_H
+#define TLSSESSIONCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QSslConfiguration>
+#include <QUrl>
+#include "entities/TlsSession.h"
+
+// TLS sessions per "host:port", so a new connection resumes the last
+// handshake with that peer instead of doing a full one.
+//
+// Shared by HttpClients and their I/O threads: ticket() and store() may be
+// called from any thread. sessions()/restore() carry the cache across
+// restarts through SecureTokenStorage.
+class TlsSessionCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int MaxSessions = 16;
+    // Lifetime when the server does not hint one
+    static constexpr qint64 DefaultLifetimeSec = 2 * 60 * 60;
+
+    explicit TlsSessionCache(QObject* parent = nullptr);
+
+    // Session to offer when connecting to `url`; empty if none is fresh
+    QByteArray ticket(const QUrl& url) const;
+
+    // Keeps the session of a finished handshake with `url`
+    void store(const QUrl& url, const QSslConfiguration& ssl);
+
+    // Unexpired sessions, for persisting
+    QList<TlsSession> sessions() const;
+    void restore(const QList<TlsSession>& sessions);
+
+signals:
+    // A session was added or replaced; emitted on the storing thread
+    void changed();
+
+private:
+    struct Entry {
+        QByteArray ticket;
+        qint64 expiresAt = 0;
+    };
+
+    static QString peerOf(const QUrl& url);
+
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+};
+
+#endif // TLSSESSIONCACHE_H
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Move-only counterpart of std::function.
+//
+// Callables up to InlineSize bytes are stored in place; larger ones go to
+// the heap. Because it never copies, captured state (batches, other
+// move-only callbacks) can be moved in once and moved out again when the
+// call happens. Hot paths whose callables are known to be larger pick a
+// bigger InlineSize.
+template<typename Signature, std::size_t InlineBytes = 4 * sizeof(void*)>
+class UniqueFunction;
+
+template<typename R, typename... Args, std::size_t InlineBytes>
+class UniqueFunction<R(Args...), InlineBytes>
+{
+public:
+    static constexpr std::size_t InlineSize = InlineBytes;
+
+    UniqueFunction() noexcept = default;
+    UniqueFunction(std::nullptr_t) noexcept {}
+
+    template<typename F>
+    requires (!std::same_as<std::remove_cvref_t<F>, UniqueFunction>)
+          && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>
+    UniqueFunction(F&& f)
+    {
+        using Fn = std::decay_t<F>;
+        if constexpr (std::is_pointer_v<Fn> || std::is_member_pointer_v<Fn>) {
+            if (!f) return;
+        }
+
+        if constexpr (fitsInline<Fn>) {
+            ::new (static_cast<void*>(m_buffer)) Fn(std::forward<F>(f));
+            m_ops = &inlineOps<Fn>;
+        } else {
+            ::new (static_cast<void*>(m_buffer)) Fn*(new Fn(std::forward<F>(f)));
+            m_ops = &heapOps<Fn>;
+        }
+    }
+
+    UniqueFunction(UniqueFunction&& other) noexcept
+    {
+        moveFrom(other);
+    }
+
+    UniqueFunction& operator=(UniqueFunction&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    UniqueFunction& operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    UniqueFunction(const UniqueFunction&) = delete;
+    UniqueFunction& operator=(const UniqueFunction&) = delete;
+
+    ~UniqueFunction() { reset(); }
+
+    explicit operator bool() const noexcept { return m_ops != nullptr; }
+
+    R operator()(Args... args)
+    {
+        return m_ops->invoke(m_buffer, std::forward<Args>(args)...);
+    }
+
+    // True when the callable lives in the inline buffer (no allocation).
+    bool isInline() const noexcept { return m_ops && m_ops->isInline; }
+
+private:
+    struct Ops {
+        R (*invoke)(void* storage, Args&&... args);
+        void (*relocate)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+        bool isInline;
+    };
+
+    template<typename Fn>
+    static constexpr bool fitsInline = sizeof(Fn) <= InlineSize
+                                    && alignof(Fn) <= alignof(std::max_align_t)
+                                    && std::is_nothrow_move_constructible_v<Fn>;
+
+    template<typename Fn>
+    static constexpr Ops inlineOps = {
+        [](void* s, Args&&... args) -> R {
+            return std::invoke(*std::launder(static_cast<Fn*>(s)), std::forward<Args>(args)...);
+        },
+        [](void* dst, void* src) noexcept {
+            Fn* from = std::launder(static_cast<Fn*>(src));
+            ::new (dst) Fn(std::move(*from));
+            from->~Fn();
+        },
+        [](void* s) noexcept {
+            std::launder(static_cast<Fn*>(s))->~Fn();
+        },
+        true,
+    };
+
+    template<typename Fn>
+    static constexpr Ops heapOps = {
+        [](void* s, Args&&... args) -> R {
+            return std::invoke(**static_cast<Fn**>(s), std::forward<Args>(args)...);
+        },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn*(*static_cast<Fn**>(src));
+        },
+        [](void* s) noexcept {
+            delete *static_cast<Fn**>(s);
+        },
+        false,
+    };
+
+    void moveFrom(UniqueFunction& other) noexcept
+    {
+        if (!other.m_ops) return;
+        other.m_ops->relocate(m_buffer, other.m_buffer);
+        m_ops = other.m_ops;
+        other.m_ops = nullptr;
+    }
+
+    void reset() noexcept
+    {
+        if (!m_ops) return;
+        m_ops->destroy(m_buffer);
+        m_ops = nullptr;
+    }
+
+    alignas(std::max_align_t) unsigned char m_buffer[InlineSize];
+    const Ops* m_ops = nullptr;
+};
+
+// Wraps a move-only callable in a copyable one that shares it. Used where a
+// Qt API insists on copying functors (queued invocations, reply handlers);
+// the wrapped callable itself is never copied.
+template<typename F>
+auto shareCallable(F&& f)
+{
+    return [shared = std::make_shared<std::decay_t<F>>(std::forward<F>(f))](auto&&... args) mutable -> decltype(auto) {
+        return (*shared)(std::forward<decltype(args)>(args)...);
+    };
+}
@@ -13,6 +13,9 @@ ApplicationWindow {
 
     color: "black"
 
+    readonly property PermissionHandle canWriteItems: PermissionManager.handle("items.write")
+    readonly property PermissionHandle canDeleteItems: PermissionManager.handle("items.delete")
+
     Flickable {
         anchors.fill: parent
         anchors.margins: 20
@@ -92,7 +95,8 @@ ApplicationWindow {
                         required property string category
                         required property string perm
 
-                        property bool granted: PermissionManager.revision >= 0 && PermissionManager.hasPermission(perm)
+                        readonly property PermissionHandle permission: PermissionManager.handle(perm)
+                        property bool granted: permission.granted
 
                         Layout.preferredWidth: 160
                         Layout.preferredHeight: 48
@@ -131,6 +135,36 @@ ApplicationWindow {
                 color: "#e0e0e0"
             }
 
+            Flow {
+                Layout.fillWidth: true
+                spacing: 8
+
+                Repeater {
+                    model: ItemModel.statusCounts
+
+                    delegate: Rectangle {
+                        required property string key
+                        required property int count
+
+                        width: countLabel.implicitWidth + 16
+                        height: 24
+                        radius: 12
+                        color: "#1a1a2e"
+                        border.color: "#444"
+                        border.width: 1
+                        visible: count > 0
+
+                        Text {
+                            id: countLabel
+                            anchors.centerIn: parent
+                            text: key + ": " + count
+                            color: "#ccc"
+                            font.pointSize: 9
+                        }
+                    }
+                }
+            }
+
             Rectangle {
                 Layout.fillWidth: true
                 height: 32
@@ -155,7 +189,7 @@ ApplicationWindow {
                 color: "#1a1a2e"
                 border.color: "#444"
                 border.width: 1
-                visible: PermissionManager.revision >= 0 && PermissionManager.hasPermission("items.write")
+                visible: app.canWriteItems.granted
 
                 RowLayout {
                     id: createRow
@@ -228,7 +262,7 @@ ApplicationWindow {
 
                         RowLayout {
                             spacing: 4
-                            visible: PermissionManager.revision >= 0 && PermissionManager.hasPermission("items.write")
+                            visible: app.canWriteItems.granted
 
                             TextField {
                                 id: editName
@@ -247,7 +281,7 @@ ApplicationWindow {
 
                         Button {
                             text: "DELETE"
-                            visible: PermissionManager.revision >= 0 && PermissionManager.hasPermission("items.delete")
+                            visible: app.canDeleteItems.granted
                             enabled: !ItemModel.loading
                             onClicked: ItemModel.remove(id)
                         }
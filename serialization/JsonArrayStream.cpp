@@ -0,0 +1,100 @@
+#include "JsonArrayStream.h"
+
+namespace {
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+} // namespace
+
+bool JsonArrayStream::feed(QByteArrayView chunk, const ElementFn& onElement)
+{
+    const char* const data = chunk.data();
+    const qsizetype size = chunk.size();
+    qsizetype segment = 0;   // start of the bytes not yet copied into m_element
+
+    for (qsizetype i = 0; i < size; ++i) {
+        const char c = data[i];
+
+        switch (m_state) {
+        case Start:
+            if (isSpace(c)) continue;
+            if (c != '[') return fail();
+            m_state = Elements;
+            segment = i + 1;
+            continue;
+        case Done:
+            if (!isSpace(c)) return fail();
+            continue;
+        case Error:
+            return false;
+        case Elements:
+            break;
+        }
+
+        if (m_inString) {
+            if (m_escape) m_escape = false;
+            else if (c == '\\') m_escape = true;
+            else if (c == '"') m_inString = false;
+            continue;
+        }
+
+        switch (c) {
+        case '"':
+            m_inString = true;
+            break;
+        case '{':
+        case '[':
+            ++m_depth;
+            break;
+        case '}':
+        case ']':
+            if (m_depth > 0) {
+                --m_depth;
+                break;
+            }
+            if (c == '}') return fail();
+            [[fallthrough]];
+        case ',':
+            if (m_depth > 0) break;
+            m_element.append(data + segment, i - segment);
+            segment = i + 1;
+            if (!endElement(c, onElement)) return false;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (m_state == Elements) {
+        m_element.append(data + segment, size - segment);
+        if (m_element.size() > MaxElementSize) return fail();
+    }
+    return m_state != Error;
+}
+
+bool JsonArrayStream::endElement(char delimiter, const ElementFn& onElement)
+{
+    const QByteArrayView element = QByteArrayView(m_element).trimmed();
+
+    if (element.isEmpty()) {
+        // Only "[]" may close without an element; "[1,]" and "[,1]" may not
+        if (delimiter != ']' || m_seenElement) return fail();
+    } else {
+        m_seenElement = true;
+        if (!onElement(element)) return fail();
+    }
+
+    m_element.resize(0);
+    if (delimiter == ']') m_state = Done;
+    return true;
+}
+
+bool JsonArrayStream::fail()
+{
+    m_state = Error;
+    m_element.clear();
+    return false;
+}
@@ -0,0 +1,43 @@
+#ifndef JSONARRAYSTREAM_H
+#define JSONARRAYSTREAM_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <functional>
+
+// Splits a top-level JSON array that arrives in arbitrary chunks into the
+// text of its elements.
+//
+// Only the element in progress is buffered, so a response of any length
+// can be handled in constant memory. Elements are delimited, not
+// validated; each one is meant to be handed to a JsonReader.
+class JsonArrayStream
+{
+public:
+    // Longest element accepted before the stream counts as malformed
+    static constexpr qsizetype MaxElementSize = 1024 * 1024;
+
+    // Returning false from `onElement` stops the stream like an error
+    using ElementFn = std::function<bool(QByteArrayView element)>;
+
+    bool feed(QByteArrayView chunk, const ElementFn& onElement);
+
+    // The closing bracket has been seen
+    bool finished() const { return m_state == Done; }
+    bool hasError() const { return m_state == Error; }
+
+private:
+    enum State { Start, Elements, Done, Error };
+
+    bool fail();
+    bool endElement(char delimiter, const ElementFn& onElement);
+
+    State      m_state = Start;
+    QByteArray m_element;
+    int        m_depth = 0;
+    bool       m_inString = false;
+    bool       m_escape = false;
+    bool       m_seenElement = false;
+};
+
+#endif // JSONARRAYSTREAM_H
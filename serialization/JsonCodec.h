@@ -0,0 +1,272 @@
+#ifndef JSONCODEC_H
+#define JSONCODEC_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QLatin1StringView>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <string_view>
+#include <tuple>
+#include "JsonReader.h"
+#include "JsonWriter.h"
+
+// Compile-time JSON codecs for plain entity structs.
+//
+// An entity opts in by specialising JsonCodec::Fields<T> with a constexpr
+// tuple of field() descriptors. write()/read() are instantiated from that
+// table: encoding goes straight into a JsonWriter buffer, decoding matches
+// member names from the JsonReader token stream against the table. No
+// QJsonObject, no virtual dispatch.
+//
+//   template<> struct JsonCodec::Fields<Item> {
+//       static constexpr auto list = std::tuple{
+//           JsonCodec::field("id",   &Item::id, JsonCodec::NumberAsString),
+//           JsonCodec::field("name", &Item::name),
+//       };
+//   };
+namespace JsonCodec {
+
+enum FieldFlag {
+    NoFlags        = 0,
+    // Accept a JSON number for a QString member and keep its literal text
+    NumberAsString = 1,
+};
+
+template<typename Owner, typename T>
+struct Field {
+    std::string_view key;
+    T Owner::* member;
+    int flags;
+};
+
+template<typename Owner, typename T>
+constexpr Field<Owner, T> field(std::string_view key, T Owner::* member, int flags = NoFlags)
+{
+    return Field<Owner, T>{ key, member, flags };
+}
+
+template<typename T>
+struct Fields;
+
+template<typename T>
+concept Described = requires { Fields<T>::list; };
+
+template<Described T> void write(JsonWriter& w, const T& entity);
+template<Described T> bool read(JsonReader& r, T& entity);
+template<Described T> void reset(T& entity);
+
+// Value codecs
+
+inline void writeValue(JsonWriter& w, const QString& value) { w.string(value); }
+inline void writeValue(JsonWriter& w, int value) { w.number(value); }
+inline void writeValue(JsonWriter& w, qint64 value) { w.number(value); }
+inline void writeValue(JsonWriter& w, bool value) { w.boolean(value); }
+
+inline void writeValue(JsonWriter& w, const QStringList& value)
+{
+    w.beginArray();
+    for (const QString& s : value)
+        w.string(s);
+    w.endArray();
+}
+
+template<Described T>
+void writeValue(JsonWriter& w, const T& value) { write(w, value); }
+
+template<Described T>
+void writeValue(JsonWriter& w, const QList<T>& value)
+{
+    w.beginArray();
+    for (const T& e : value)
+        write(w, e);
+    w.endArray();
+}
+
+// Resetting keeps string capacity so a scratch entity can be reused
+
+inline void resetValue(QString& value) { value.resize(0); }
+inline void resetValue(QStringList& value) { value.clear(); }
+inline void resetValue(int& value) { value = 0; }
+inline void resetValue(qint64& value) { value = 0; }
+inline void resetValue(bool& value) { value = false; }
+
+template<Described T>
+void resetValue(T& value) { reset(value); }
+
+template<Described T>
+void resetValue(QList<T>& value) { value.clear(); }
+
+// Readers mirror QJsonValue's lenient conversions: a value of the wrong type
+// is skipped and the member falls back to its empty/zero value.
+
+inline bool readValue(JsonReader& r, QString& out, int flags)
+{
+    switch (r.peek()) {
+    case JsonReader::String:
+        return r.readString(out);
+    case JsonReader::Number:
+        if (flags & NumberAsString) {
+            QByteArrayView text;
+            if (!r.readNumber(text)) return false;
+            out.assign(QLatin1StringView(text));
+            return true;
+        }
+        break;
+    default:
+        break;
+    }
+    out.resize(0);
+    return r.skipValue();
+}
+
+inline bool readValue(JsonReader& r, int& out, int)
+{
+    if (r.peek() == JsonReader::Number) return r.readInt(out);
+    out = 0;
+    return r.skipValue();
+}
+
+inline bool readValue(JsonReader& r, qint64& out, int)
+{
+    if (r.peek() == JsonReader::Number) return r.readInt64(out);
+    out = 0;
+    return r.skipValue();
+}
+
+inline bool readValue(JsonReader& r, bool& out, int)
+{
+    if (r.peek() == JsonReader::Bool) return r.readBool(out);
+    out = false;
+    return r.skipValue();
+}
+
+inline bool readValue(JsonReader& r, QStringList& out, int)
+{
+    out.clear();
+    if (r.peek() != JsonReader::ArrayBegin) return r.skipValue();
+
+    r.beginArray();
+    while (r.nextElement()) {
+        if (r.peek() == JsonReader::String) {
+            QString s;
+            if (!r.readString(s)) return false;
+            out.append(std::move(s));
+        } else if (!r.skipValue()) {
+            return false;
+        }
+    }
+    return !r.hasError();
+}
+
+template<Described T>
+bool readValue(JsonReader& r, T& out, int)
+{
+    if (r.peek() != JsonReader::ObjectBegin) {
+        reset(out);
+        return r.skipValue();
+    }
+    return read(r, out);
+}
+
+// Elements that are not objects are skipped
+template<Described T>
+bool readValue(JsonReader& r, QList<T>& out, int)
+{
+    out.clear();
+    if (r.peek() != JsonReader::ArrayBegin) return r.skipValue();
+
+    r.beginArray();
+    while (r.nextElement()) {
+        if (r.peek() == JsonReader::ObjectBegin) {
+            T e;
+            if (!read(r, e)) return false;
+            out.append(std::move(e));
+        } else if (!r.skipValue()) {
+            return false;
+        }
+    }
+    return !r.hasError();
+}
+
+// Entity codecs
+
+template<Described T>
+void write(JsonWriter& w, const T& entity)
+{
+    w.beginObject();
+    std::apply([&](const auto&... f) {
+        ((w.key(f.key), writeValue(w, entity.*(f.member))), ...);
+    }, Fields<T>::list);
+    w.endObject();
+}
+
+template<Described T>
+void reset(T& entity)
+{
+    std::apply([&](const auto&... f) {
+        (resetValue(entity.*(f.member)), ...);
+    }, Fields<T>::list);
+}
+
+// Decodes the value for member `key` of `entity` if the table knows it.
+// Returns false when the key is unknown; the value is then left unread.
+template<Described T>
+bool readField(JsonReader& r, QByteArrayView key, T& entity)
+{
+    const std::string_view k(key.data(), size_t(key.size()));
+    return std::apply([&](const auto&... f) {
+        return ((k == f.key && (readValue(r, entity.*(f.member), f.flags), true)) || ...);
+    }, Fields<T>::list);
+}
+
+template<Described T>
+bool read(JsonReader& r, T& entity)
+{
+    if (!r.beginObject()) return false;
+
+    QByteArrayView key;
+    while (r.nextKey(key)) {
+        if (!readField(r, key, entity) && !r.skipValue())
+            return false;
+    }
+    return !r.hasError();
+}
+
+// Calls `fn(reader)` for every element of the array at the reader position.
+template<typename Fn>
+bool readArray(JsonReader& r, Fn&& fn)
+{
+    if (!r.beginArray()) return false;
+    while (r.nextElement()) {
+        if (!fn(r)) return false;
+    }
+    return !r.hasError();
+}
+
+template<Described T>
+void encode(const T& entity, QByteArray& out)
+{
+    JsonWriter w(out);
+    write(w, entity);
+}
+
+template<Described T>
+QByteArray encode(const T& entity)
+{
+    QByteArray out;
+    encode(entity, out);
+    return out;
+}
+
+template<Described T>
+bool decode(QByteArrayView json, T& entity)
+{
+    JsonReader r(json);
+    return r.peek() == JsonReader::ObjectBegin && read(r, entity) && r.atEnd();
+}
+
+} // namespace JsonCodec
+
+#endif // JSONCODEC_H
@@ -0,0 +1,452 @@
+#include "JsonReader.h"
+#include <cstring>
+#include <limits>
+
+namespace {
+
+inline bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void appendUtf8(QByteArray& out, char32_t cp)
+{
+    if (cp < 0x80) {
+        out.append(char(cp));
+    } else if (cp < 0x800) {
+        out.append(char(0xC0 | (cp >> 6)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.append(char(0xE0 | (cp >> 12)));
+        out.append(char(0x80 | ((cp >> 6) & 0x3F)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    } else {
+        out.append(char(0xF0 | (cp >> 18)));
+        out.append(char(0x80 | ((cp >> 12) & 0x3F)));
+        out.append(char(0x80 | ((cp >> 6) & 0x3F)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    }
+}
+
+} // namespace
+
+JsonReader::JsonReader(QByteArrayView json, Indexing indexing)
+    : m_begin(json.data())
+    , m_pos(json.data())
+    , m_end(json.data() + json.size())
+{
+    const bool wantIndex = indexing == AlwaysIndex
+                        || (indexing == AutoIndex && json.size() >= IndexThreshold);
+    if (wantIndex) {
+        m_indexed = m_index.build(json);
+        m_error = !m_indexed;
+    }
+}
+
+JsonReader::Token JsonReader::peek()
+{
+    if (m_error) return Invalid;
+    skipWhitespace();
+    if (m_pos == m_end) return Invalid;
+
+    switch (*m_pos) {
+    case '{': return ObjectBegin;
+    case '[': return ArrayBegin;
+    case '"': return String;
+    case 't':
+    case 'f': return Bool;
+    case 'n': return Null;
+    default:
+        if (*m_pos == '-' || isDigit(*m_pos)) return Number;
+        return Invalid;
+    }
+}
+
+bool JsonReader::beginObject()
+{
+    if (!expect('{')) return false;
+    m_afterOpen = true;
+    return true;
+}
+
+bool JsonReader::nextKey(QByteArrayView& key)
+{
+    if (m_error) return false;
+    skipWhitespace();
+    if (m_pos == m_end) return fail();
+
+    if (*m_pos == '}') {
+        ++m_pos;
+        m_afterOpen = false;
+        return false;
+    }
+
+    if (!m_afterOpen) {
+        if (*m_pos != ',') return fail();
+        ++m_pos;
+        skipWhitespace();
+    }
+    m_afterOpen = false;
+
+    if (m_pos == m_end || *m_pos != '"') return fail();
+    const char* start = m_pos + 1;
+    const char* contentEnd = nullptr;
+    bool hasEscapes = false;
+    if (!scanString(contentEnd, hasEscapes)) return false;
+    key = QByteArrayView(start, contentEnd - start);
+
+    return expect(':');
+}
+
+bool JsonReader::beginArray()
+{
+    if (!expect('[')) return false;
+    m_afterOpen = true;
+    return true;
+}
+
+bool JsonReader::nextElement()
+{
+    if (m_error) return false;
+    skipWhitespace();
+    if (m_pos == m_end) return fail();
+
+    if (*m_pos == ']') {
+        ++m_pos;
+        m_afterOpen = false;
+        return false;
+    }
+
+    if (!m_afterOpen) {
+        if (*m_pos != ',') return fail();
+        ++m_pos;
+    }
+    m_afterOpen = false;
+    return true;
+}
+
+bool JsonReader::readString(QString& out)
+{
+    if (peek() != String) return fail();
+
+    const char* start = m_pos + 1;
+    const char* contentEnd = nullptr;
+    bool hasEscapes = false;
+    if (!scanString(contentEnd, hasEscapes)) return false;
+
+    // assign() reuses out's buffer when it is large enough, so a scratch
+    // entity decoded in a loop stops allocating once warmed up
+    if (!hasEscapes) {
+        out.assign(QUtf8StringView(start, contentEnd - start));
+        return true;
+    }
+    return unescape(start, contentEnd, out);
+}
+
+bool JsonReader::readNumber(QByteArrayView& text)
+{
+    if (peek() != Number) return fail();
+    const char* start = m_pos;
+    if (!scanNumber()) return false;
+    text = QByteArrayView(start, m_pos - start);
+    return true;
+}
+
+bool JsonReader::readInt(int& out)
+{
+    QByteArrayView text;
+    if (!readNumber(text)) return false;
+
+    // Same contract as QJsonValue::toInt(): integral values in range only
+    bool ok = false;
+    const double d = text.toDouble(&ok);
+    const bool inRange = ok && d >= double(std::numeric_limits<int>::min())
+                            && d <= double(std::numeric_limits<int>::max());
+    out = (inRange && d == double(int(d))) ? int(d) : 0;
+    return true;
+}
+
+bool JsonReader::readInt64(qint64& out)
+{
+    QByteArrayView text;
+    if (!readNumber(text)) return false;
+
+    // Same contract as QJsonValue::toInteger()
+    bool ok = false;
+    const double d = text.toDouble(&ok);
+    const bool inRange = ok && d >= -9223372036854775808.0 && d < 9223372036854775808.0;
+    out = (inRange && d == double(qint64(d))) ? qint64(d) : 0;
+    return true;
+}
+
+bool JsonReader::readBool(bool& out)
+{
+    if (peek() != Bool) return fail();
+    if (*m_pos == 't') {
+        out = true;
+        return expectLiteral("true", 4);
+    }
+    out = false;
+    return expectLiteral("false", 5);
+}
+
+bool JsonReader::readNull()
+{
+    if (peek() != Null) return fail();
+    return expectLiteral("null", 4);
+}
+
+bool JsonReader::skipValue()
+{
+    switch (peek()) {
+    case String: {
+        const char* contentEnd = nullptr;
+        bool hasEscapes = false;
+        return scanString(contentEnd, hasEscapes);
+    }
+    case Number:
+        return scanNumber();
+    case Bool: {
+        bool ignored = false;
+        return readBool(ignored);
+    }
+    case Null:
+        return readNull();
+    case ObjectBegin: {
+        if (m_indexed) return skipIndexedContainer();
+        if (!beginObject()) return false;
+        QByteArrayView key;
+        while (nextKey(key)) {
+            if (!skipValue()) return false;
+        }
+        return !m_error;
+    }
+    case ArrayBegin: {
+        if (m_indexed) return skipIndexedContainer();
+        if (!beginArray()) return false;
+        while (nextElement()) {
+            if (!skipValue()) return false;
+        }
+        return !m_error;
+    }
+    case Invalid:
+        break;
+    }
+    return fail();
+}
+
+bool JsonReader::atEnd()
+{
+    if (m_error) return false;
+    skipWhitespace();
+    return m_pos == m_end;
+}
+
+void JsonReader::skipWhitespace()
+{
+    while (m_pos != m_end && isWhitespace(*m_pos))
+        ++m_pos;
+}
+
+bool JsonReader::fail()
+{
+    m_error = true;
+    return false;
+}
+
+bool JsonReader::expect(char c)
+{
+    if (m_error) return false;
+    skipWhitespace();
+    if (m_pos == m_end || *m_pos != c) return fail();
+    ++m_pos;
+    return true;
+}
+
+bool JsonReader::expectLiteral(const char* literal, qsizetype length)
+{
+    if (m_end - m_pos < length || std::memcmp(m_pos, literal, size_t(length)) != 0)
+        return fail();
+    m_pos += length;
+    return true;
+}
+
+// Expects m_pos on the opening quote. Leaves m_pos past the closing quote
+// and contentEnd on it.
+bool JsonReader::scanString(const char*& contentEnd, bool& hasEscapes)
+{
+    if (m_indexed) {
+        // Both quotes are indexed; stage 1 already rejected raw control chars
+        const qsizetype i = seekIndex(m_pos);
+        if (i + 1 >= m_index.size() || m_begin + m_index.at(i) != m_pos) return fail();
+
+        const char* close = m_begin + m_index.at(i + 1);
+        if (*close != '"') return fail();
+
+        hasEscapes = std::memchr(m_pos + 1, '\\', size_t(close - m_pos - 1)) != nullptr;
+        contentEnd = close;
+        m_pos = close + 1;
+        m_indexCursor = i + 2;
+        return true;
+    }
+
+    const char* p = m_pos + 1;
+    while (p != m_end) {
+        const unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"') {
+            contentEnd = p;
+            m_pos = p + 1;
+            return true;
+        }
+        if (c == '\\') {
+            hasEscapes = true;
+            if (++p == m_end || *p == '\0' || !std::strchr("\"\\/bfnrtu", *p)) break;
+        } else if (c < 0x20) {
+            break;
+        }
+        ++p;
+    }
+    return fail();
+}
+
+// Expects m_pos on '{' or '['. Walks the index to the matching close
+// without touching the bytes in between.
+bool JsonReader::skipIndexedContainer()
+{
+    const qsizetype n = m_index.size();
+    int depth = 0;
+    for (qsizetype i = seekIndex(m_pos); i < n; ++i) {
+        const char c = m_begin[m_index.at(i)];
+        if (c == '{' || c == '[') {
+            ++depth;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0) {
+                m_pos = m_begin + m_index.at(i) + 1;
+                m_indexCursor = i + 1;
+                m_afterOpen = false;
+                return true;
+            }
+        }
+    }
+    return fail();
+}
+
+// The reader only moves forward, so the cursor catches up in amortised O(1).
+qsizetype JsonReader::seekIndex(const char* p)
+{
+    const quint32 offset = quint32(p - m_begin);
+    const qsizetype n = m_index.size();
+    while (m_indexCursor < n && m_index.at(m_indexCursor) < offset)
+        ++m_indexCursor;
+    return m_indexCursor;
+}
+
+bool JsonReader::scanNumber()
+{
+    const char* p = m_pos;
+    if (p != m_end && *p == '-') ++p;
+
+    if (p == m_end || !isDigit(*p)) return fail();
+    if (*p == '0') {
+        ++p;
+    } else {
+        while (p != m_end && isDigit(*p)) ++p;
+    }
+
+    if (p != m_end && *p == '.') {
+        ++p;
+        if (p == m_end || !isDigit(*p)) return fail();
+        while (p != m_end && isDigit(*p)) ++p;
+    }
+
+    if (p != m_end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        if (p != m_end && (*p == '+' || *p == '-')) ++p;
+        if (p == m_end || !isDigit(*p)) return fail();
+        while (p != m_end && isDigit(*p)) ++p;
+    }
+
+    m_pos = p;
+    return true;
+}
+
+bool JsonReader::unescape(const char* begin, const char* end, QString& out)
+{
+    m_scratch.clear();
+    m_scratch.reserve(end - begin);
+
+    const char* p = begin;
+    while (p != end) {
+        const char* run = p;
+        while (p != end && *p != '\\') ++p;
+        m_scratch.append(run, p - run);
+        if (p == end) break;
+
+        ++p; // backslash; scanString guarantees a following byte
+        switch (*p++) {
+        case '"':  m_scratch.append('"');  break;
+        case '\\': m_scratch.append('\\'); break;
+        case '/':  m_scratch.append('/');  break;
+        case 'b':  m_scratch.append('\b'); break;
+        case 'f':  m_scratch.append('\f'); break;
+        case 'n':  m_scratch.append('\n'); break;
+        case 'r':  m_scratch.append('\r'); break;
+        case 't':  m_scratch.append('\t'); break;
+        case 'u': {
+            auto readHex4 = [&](char32_t& unit) {
+                if (end - p < 4) return false;
+                unit = 0;
+                for (int i = 0; i < 4; ++i) {
+                    const int v = hexValue(p[i]);
+                    if (v < 0) return false;
+                    unit = (unit << 4) | char32_t(v);
+                }
+                p += 4;
+                return true;
+            };
+
+            char32_t cp = 0;
+            if (!readHex4(cp)) return fail();
+
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                char32_t low = 0;
+                if (end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                    p += 2;
+                    if (!readHex4(low)) return fail();
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    } else {
+                        // Lone high surrogate followed by an unrelated escape
+                        appendUtf8(m_scratch, 0xFFFD);
+                        cp = (low >= 0xD800 && low <= 0xDFFF) ? 0xFFFD : low;
+                    }
+                } else {
+                    cp = 0xFFFD;
+                }
+            } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                cp = 0xFFFD;
+            }
+            appendUtf8(m_scratch, cp);
+            break;
+        }
+        default:
+            return fail();
+        }
+    }
+
+    out.assign(QUtf8StringView(m_scratch));
+    return true;
+}
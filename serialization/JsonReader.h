@@ -0,0 +1,94 @@
+#ifndef JSONREADER_H
+#define JSONREADER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+#include <QUtf8StringView>
+#include "StructuralIndex.h"
+
+// Pull tokenizer over a UTF-8 JSON document.
+//
+// Values are consumed in document order straight from the input bytes; no
+// DOM is built. Callers drive it with peek() and the typed read/skip calls.
+// Every call returns false once the input is malformed and hasError() stays
+// set from then on, so decode loops can bail out with a single check.
+//
+// Large inputs are first run through a SIMD StructuralIndex. String bodies
+// and skipped containers are then crossed by jumping between indexed
+// offsets; the content of skipped values is not re-validated in that mode.
+class JsonReader
+{
+public:
+    enum Indexing {
+        AutoIndex = 0,   // index inputs of at least IndexThreshold bytes
+        AlwaysIndex,
+        NeverIndex,
+    };
+
+    static constexpr qsizetype IndexThreshold = 64 * 1024;
+
+    enum Token {
+        Invalid = 0,
+        ObjectBegin,
+        ArrayBegin,
+        String,
+        Number,
+        Bool,
+        Null,
+    };
+
+    explicit JsonReader(QByteArrayView json, Indexing indexing = AutoIndex);
+
+    // Type of the next value; Invalid on malformed input or end of data.
+    Token peek();
+
+    bool beginObject();
+    // Reads the next member name and its ':'. Returns false after consuming
+    // the closing '}', or on error. Names are returned undecoded.
+    bool nextKey(QByteArrayView& key);
+
+    bool beginArray();
+    // Positions on the next element. Returns false after consuming the
+    // closing ']', or on error.
+    bool nextElement();
+
+    bool readString(QString& out);
+    bool readNumber(QByteArrayView& text);
+    bool readInt(int& out);
+    bool readInt64(qint64& out);
+    bool readBool(bool& out);
+    bool readNull();
+    bool skipValue();
+
+    // True when only whitespace remains.
+    bool atEnd();
+
+    bool hasError() const { return m_error; }
+    bool isIndexed() const { return m_indexed; }
+    qsizetype offset() const { return m_pos - m_begin; }
+
+private:
+    void skipWhitespace();
+    bool fail();
+    bool expect(char c);
+    bool expectLiteral(const char* literal, qsizetype length);
+    bool scanString(const char*& contentEnd, bool& hasEscapes);
+    bool scanNumber();
+    bool skipIndexedContainer();
+    qsizetype seekIndex(const char* p);
+    bool unescape(const char* begin, const char* end, QString& out);
+
+    const char* m_begin;
+    const char* m_pos;
+    const char* m_end;
+    bool        m_afterOpen = false;
+    bool        m_error = false;
+    QByteArray  m_scratch;
+
+    StructuralIndex m_index;
+    qsizetype       m_indexCursor = 0;
+    bool            m_indexed = false;
+};
+
+#endif // JSONREADER_H
@@ -0,0 +1,149 @@
+#include "JsonWriter.h"
+#include <charconv>
+#include <cmath>
+
+namespace {
+
+inline char hexDigit(int v)
+{
+    return "0123456789abcdef"[v & 0xF];
+}
+
+} // namespace
+
+void JsonWriter::beginObject()
+{
+    separate();
+    m_out.append('{');
+    m_needComma = false;
+}
+
+void JsonWriter::endObject()
+{
+    m_out.append('}');
+    m_needComma = true;
+}
+
+void JsonWriter::beginArray()
+{
+    separate();
+    m_out.append('[');
+    m_needComma = false;
+}
+
+void JsonWriter::endArray()
+{
+    m_out.append(']');
+    m_needComma = true;
+}
+
+void JsonWriter::key(std::string_view name)
+{
+    separate();
+    m_out.append('"');
+    m_out.append(name.data(), qsizetype(name.size()));
+    m_out.append("\":", 2);
+    m_needComma = false;
+}
+
+void JsonWriter::string(QStringView value)
+{
+    separate();
+    m_out.reserve(m_out.size() + value.size() + 2);
+    m_out.append('"');
+
+    const char16_t* p = value.utf16();
+    const char16_t* const end = p + value.size();
+    while (p != end) {
+        const char16_t c = *p++;
+
+        if (c < 0x80) {
+            if (c == '"' || c == '\\') {
+                m_out.append('\\');
+                m_out.append(char(c));
+            } else if (c >= 0x20) {
+                m_out.append(char(c));
+            } else {
+                switch (c) {
+                case '\n': m_out.append("\\n", 2); break;
+                case '\r': m_out.append("\\r", 2); break;
+                case '\t': m_out.append("\\t", 2); break;
+                case '\b': m_out.append("\\b", 2); break;
+                case '\f': m_out.append("\\f", 2); break;
+                default:
+                    m_out.append("\\u00", 4);
+                    m_out.append(hexDigit(c >> 4));
+                    m_out.append(hexDigit(c));
+                }
+            }
+            continue;
+        }
+
+        if (c < 0x800) {
+            m_out.append(char(0xC0 | (c >> 6)));
+            m_out.append(char(0x80 | (c & 0x3F)));
+            continue;
+        }
+
+        char32_t cp = c;
+        if (c >= 0xD800 && c <= 0xDBFF && p != end && *p >= 0xDC00 && *p <= 0xDFFF) {
+            cp = 0x10000 + ((char32_t(c) - 0xD800) << 10) + (char32_t(*p++) - 0xDC00);
+            m_out.append(char(0xF0 | (cp >> 18)));
+            m_out.append(char(0x80 | ((cp >> 12) & 0x3F)));
+            m_out.append(char(0x80 | ((cp >> 6) & 0x3F)));
+            m_out.append(char(0x80 | (cp & 0x3F)));
+            continue;
+        }
+        if (c >= 0xD800 && c <= 0xDFFF)
+            cp = 0xFFFD; // unpaired surrogate
+
+        m_out.append(char(0xE0 | (cp >> 12)));
+        m_out.append(char(0x80 | ((cp >> 6) & 0x3F)));
+        m_out.append(char(0x80 | (cp & 0x3F)));
+    }
+
+    m_out.append('"');
+    m_needComma = true;
+}
+
+void JsonWriter::number(qint64 value)
+{
+    separate();
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    m_out.append(digits, result.ptr - digits);
+    m_needComma = true;
+}
+
+void JsonWriter::real(double value)
+{
+    if (!std::isfinite(value)) {
+        null();
+        return;
+    }
+    separate();
+    char digits[32];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    m_out.append(digits, result.ptr - digits);
+    m_needComma = true;
+}
+
+void JsonWriter::boolean(bool value)
+{
+    separate();
+    if (value) m_out.append("true", 4);
+    else m_out.append("false", 5);
+    m_needComma = true;
+}
+
+void JsonWriter::null()
+{
+    separate();
+    m_out.append("null", 4);
+    m_needComma = true;
+}
+
+void JsonWriter::separate()
+{
+    if (m_needComma) m_out.append(',');
+}
@@ -0,0 +1,42 @@
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <QByteArray>
+#include <QStringView>
+#include <string_view>
+
+// Appends compact UTF-8 JSON to a caller-owned buffer.
+//
+// The buffer is only ever appended to, so one QByteArray can be cleared and
+// reused across documents without giving its capacity back. Member names are
+// written verbatim and must not need escaping (they come from field tables).
+class JsonWriter
+{
+public:
+    explicit JsonWriter(QByteArray& out) : m_out(out) {}
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    void key(std::string_view name);
+
+    void string(QStringView value);
+    void number(qint64 value);
+    // Shortest form that reads back as `value`; null when not finite. A
+    // separate name, so integer arguments never become ambiguous.
+    void real(double value);
+    void boolean(bool value);
+    void null();
+
+    QByteArray& buffer() { return m_out; }
+
+private:
+    void separate();
+
+    QByteArray& m_out;
+    bool        m_needComma = false;
+};
+
+#endif // JSONWRITER_H
@@ -0,0 +1,251 @@
+#include "StructuralIndex.h"
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define STRUCTURAL_INDEX_X86 1
+#  include <immintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#    define TARGET_SSE42
+#    define TARGET_AVX2
+#  else
+#    define TARGET_SSE42 __attribute__((target("sse4.2")))
+#    define TARGET_AVX2  __attribute__((target("avx2")))
+#  endif
+#endif
+
+namespace {
+
+// Per-64-byte-block character classes, one bit per byte.
+struct BlockMasks {
+    quint64 quote = 0;
+    quint64 backslash = 0;
+    quint64 op = 0;        // { } [ ] : ,
+    quint64 control = 0;   // bytes < 0x20
+};
+
+using ClassifyFn = BlockMasks (*)(const char* block);
+
+BlockMasks classifyScalar(const char* block)
+{
+    BlockMasks m;
+    for (int i = 0; i < 64; ++i) {
+        const unsigned char c = static_cast<unsigned char>(block[i]);
+        const quint64 bit = quint64(1) << i;
+        switch (c) {
+        case '"':  m.quote |= bit; break;
+        case '\\': m.backslash |= bit; break;
+        case '{': case '}': case '[': case ']': case ':': case ',':
+            m.op |= bit;
+            break;
+        default:
+            if (c < 0x20) m.control |= bit;
+        }
+    }
+    return m;
+}
+
+#ifdef STRUCTURAL_INDEX_X86
+
+TARGET_SSE42 BlockMasks classifySse42(const char* block)
+{
+    // PCMPESTRM matches each byte against the whole structural set at once
+    const __m128i opSet = _mm_setr_epi8('{', '}', '[', ']', ':', ',', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i controlMax = _mm_set1_epi8(0x1F);
+
+    BlockMasks m;
+    for (int i = 0; i < 4; ++i) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+        const int shift = i * 16;
+
+        const __m128i op = _mm_cmpestrm(opSet, 6, v, 16,
+                                        _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK);
+        m.op |= quint64(quint16(_mm_cvtsi128_si32(op))) << shift;
+        m.quote |= quint64(quint16(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+        m.backslash |= quint64(quint16(_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)))) << shift;
+        const __m128i ctrl = _mm_cmpeq_epi8(_mm_min_epu8(v, controlMax), v);
+        m.control |= quint64(quint16(_mm_movemask_epi8(ctrl))) << shift;
+    }
+    return m;
+}
+
+TARGET_AVX2 BlockMasks classifyAvx2(const char* block)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i controlMax = _mm256_set1_epi8(0x1F);
+    const __m256i braceOpen = _mm256_set1_epi8('{');
+    const __m256i braceClose = _mm256_set1_epi8('}');
+    const __m256i bracketOpen = _mm256_set1_epi8('[');
+    const __m256i bracketClose = _mm256_set1_epi8(']');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+
+    BlockMasks m;
+    for (int i = 0; i < 2; ++i) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i * 32));
+        const int shift = i * 32;
+
+        __m256i op = _mm256_or_si256(_mm256_cmpeq_epi8(v, braceOpen), _mm256_cmpeq_epi8(v, braceClose));
+        op = _mm256_or_si256(op, _mm256_cmpeq_epi8(v, bracketOpen));
+        op = _mm256_or_si256(op, _mm256_cmpeq_epi8(v, bracketClose));
+        op = _mm256_or_si256(op, _mm256_cmpeq_epi8(v, colon));
+        op = _mm256_or_si256(op, _mm256_cmpeq_epi8(v, comma));
+
+        m.op |= quint64(quint32(_mm256_movemask_epi8(op))) << shift;
+        m.quote |= quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)))) << shift;
+        m.backslash |= quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash)))) << shift;
+        const __m256i ctrl = _mm256_cmpeq_epi8(_mm256_min_epu8(v, controlMax), v);
+        m.control |= quint64(quint32(_mm256_movemask_epi8(ctrl))) << shift;
+    }
+    return m;
+}
+
+#endif // STRUCTURAL_INDEX_X86
+
+ClassifyFn classifierFor(StructuralIndex::Kernel kernel)
+{
+#ifdef STRUCTURAL_INDEX_X86
+    switch (kernel) {
+    case StructuralIndex::Avx2:  return &classifyAvx2;
+    case StructuralIndex::Sse42: return &classifySse42;
+    case StructuralIndex::Scalar: break;
+    }
+#else
+    Q_UNUSED(kernel);
+#endif
+    return &classifyScalar;
+}
+
+inline int countTrailingZeros(quint64 x)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return int(index);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// Running XOR from the lowest bit up: bit i is set when an odd number of
+// bits at or below i are set. Turns quote positions into "inside string".
+inline quint64 prefixXor(quint64 x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// Marks characters preceded by an odd-length run of backslashes. The carry
+// tracks a run that spills over from the previous block.
+inline quint64 escapedChars(quint64 backslash, quint64& carry)
+{
+    constexpr quint64 oddBits = 0xAAAAAAAAAAAAAAAAULL;
+
+    if (!backslash) {
+        const quint64 escaped = carry;
+        carry = 0;
+        return escaped;
+    }
+
+    const quint64 potential = backslash & ~carry;
+    const quint64 maybeEscaped = potential << 1;
+    const quint64 codes = ((maybeEscaped | oddBits) - potential) ^ oddBits;
+    const quint64 escaped = codes ^ (backslash | carry);
+    carry = (codes & backslash) >> 63;
+    return escaped;
+}
+
+} // namespace
+
+StructuralIndex::Kernel StructuralIndex::bestKernel()
+{
+    static const Kernel kernel = []() {
+#if defined(STRUCTURAL_INDEX_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        const bool sse42 = info[2] & (1 << 20);
+        const bool osxsave = info[2] & (1 << 27);
+        __cpuidex(info, 7, 0);
+        const bool avx2 = (info[1] & (1 << 5)) && osxsave && (_xgetbv(0) & 0x6) == 0x6;
+        if (avx2) return Avx2;
+        if (sse42) return Sse42;
+#elif defined(STRUCTURAL_INDEX_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return Avx2;
+        if (__builtin_cpu_supports("sse4.2")) return Sse42;
+#endif
+        return Scalar;
+    }();
+    return kernel;
+}
+
+const char* StructuralIndex::kernelName(Kernel kernel)
+{
+    switch (kernel) {
+    case Avx2:   return "avx2";
+    case Sse42:  return "sse4.2";
+    case Scalar: break;
+    }
+    return "scalar";
+}
+
+bool StructuralIndex::build(QByteArrayView json)
+{
+    return build(json, bestKernel());
+}
+
+bool StructuralIndex::build(QByteArrayView json, Kernel kernel)
+{
+    m_positions.clear();
+    if (json.size() > qsizetype(std::numeric_limits<quint32>::max()))
+        return false;
+
+    const ClassifyFn classify = classifierFor(kernel);
+    const char* data = json.data();
+    const qsizetype size = json.size();
+
+    // Structurals are typically well under a quarter of the bytes
+    m_positions.reserve(size / 4 + 16);
+
+    quint64 escapeCarry = 0;
+    quint64 inStringCarry = 0;   // all ones when the previous block ended inside a string
+    char tail[64];
+
+    for (qsizetype base = 0; base < size; base += 64) {
+        const char* block = data + base;
+        if (size - base < 64) {
+            // Pad the last block with spaces: they belong to no class
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, block, size_t(size - base));
+            block = tail;
+        }
+
+        const BlockMasks m = classify(block);
+
+        const quint64 escaped = escapedChars(m.backslash, escapeCarry);
+        const quint64 quotes = m.quote & ~escaped;
+        const quint64 inString = prefixXor(quotes) ^ inStringCarry;
+        inStringCarry = quint64(qint64(inString) >> 63);
+
+        // inString covers the opening quote up to, not including, the closing one
+        if (m.control & inString)
+            return false;
+
+        quint64 structurals = (m.op & ~inString) | quotes;
+        while (structurals) {
+            m_positions.append(quint32(base + countTrailingZeros(structurals)));
+            structurals &= structurals - 1;
+        }
+    }
+
+    return inStringCarry == 0;
+}
@@ -0,0 +1,42 @@
+#ifndef STRUCTURALINDEX_H
+#define STRUCTURALINDEX_H
+
+#include <QByteArrayView>
+#include <QList>
+
+// Stage 1 of a two-stage JSON parse.
+//
+// build() classifies the input 64 bytes at a time with SIMD compares and
+// records the offset of every structural character outside strings
+// ({ } [ ] : ,) plus every unescaped quote, i.e. both ends of each string.
+// JsonReader then uses the index to jump over string bodies and skipped
+// objects/arrays instead of walking them byte by byte.
+//
+// The kernel is picked once at runtime from what the CPU supports (AVX2,
+// SSE4.2, scalar fallback); build() can be forced onto a specific one.
+class StructuralIndex
+{
+public:
+    enum Kernel {
+        Scalar = 0,
+        Sse42,
+        Avx2,
+    };
+
+    static Kernel bestKernel();
+    static const char* kernelName(Kernel kernel);
+
+    // Returns false for an unterminated string or a raw control character
+    // inside a string; the index is then unusable.
+    bool build(QByteArrayView json);
+    bool build(QByteArrayView json, Kernel kernel);
+
+    const quint32* positions() const { return m_positions.constData(); }
+    qsizetype size() const { return m_positions.size(); }
+    quint32 at(qsizetype i) const { return m_positions.at(i); }
+
+private:
+    QList<quint32> m_positions;
+};
+
+#endif // STRUCTURALINDEX_H
@@ -0,0 +1,92 @@
+#include "StartupPipeline.h"
+#include <QMetaObject>
+#include <QThreadPool>
+#include <algorithm>
+#include "StartupTrace.h"
+
+StartupPipeline::StartupPipeline(StartupTrace& trace, QObject* parent)
+    : QObject(parent), m_trace(trace) {}
+
+void StartupPipeline::add(const QString& name, const QStringList& dependsOn, Thread thread,
+                          std::function<void()> task)
+{
+    m_tasks.append(Task{ name, dependsOn, thread, std::move(task) });
+    ++m_remaining;
+}
+
+void StartupPipeline::start()
+{
+    // A misspelled dependency would otherwise let its task run too early,
+    // in release builds too
+    for (const Task& task : std::as_const(m_tasks)) {
+        for (const QString& dep : task.dependsOn) {
+            if (!find(dep))
+                qFatal("[Startup] task \"%s\" depends on unknown task \"%s\"",
+                       qPrintable(task.name), qPrintable(dep));
+        }
+    }
+    schedule();
+}
+
+const StartupPipeline::Task* StartupPipeline::find(const QString& name) const
+{
+    const auto it = std::find_if(m_tasks.cbegin(), m_tasks.cend(),
+                                 [&](const Task& t) { return t.name == name; });
+    return it != m_tasks.cend() ? &*it : nullptr;
+}
+
+bool StartupPipeline::isReady(const Task& task) const
+{
+    if (task.state != Pending) return false;
+    for (const QString& dep : task.dependsOn) {
+        // Every name was checked in start()
+        if (find(dep)->state != Done) return false;
+    }
+    return true;
+}
+
+void StartupPipeline::schedule()
+{
+    for (;;) {
+        for (qsizetype i = 0; i < m_tasks.size(); ++i) {
+            Task& task = m_tasks[i];
+            if (task.thread != Background || !isReady(task)) continue;
+
+            task.state = Running;
+            QThreadPool::globalInstance()->start([this, i, run = task.run]() {
+                const qint64 begin = m_trace.now();
+                run();
+                const qint64 end = m_trace.now();
+                QMetaObject::invokeMethod(this, [this, i, begin, end]() {
+                    complete(i, begin, end);
+                }, Qt::QueuedConnection);
+            });
+        }
+
+        const auto next = std::find_if(m_tasks.begin(), m_tasks.end(), [&](const Task& t) {
+            return t.thread == MainThread && isReady(t);
+        });
+        if (next == m_tasks.end()) break;
+
+        next->state = Running;
+        const qint64 begin = m_trace.now();
+        next->run();
+        const qint64 end = m_trace.now();
+
+        next->state = Done;
+        --m_remaining;
+        m_trace.record(next->name, begin, end, false);
+    }
+
+    if (m_remaining == 0)
+        emit finished();
+}
+
+void StartupPipeline::complete(qsizetype index, qint64 beginNs, qint64 endNs)
+{
+    Task& task = m_tasks[index];
+    task.state = Done;
+    --m_remaining;
+    m_trace.record(task.name, beginNs, endNs, true);
+    schedule();
+}
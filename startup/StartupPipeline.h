@@ -0,0 +1,59 @@
+#ifndef STARTUPPIPELINE_H
+#define STARTUPPIPELINE_H
+
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include <functional>
+
+class StartupTrace;
+
+// Runs named startup tasks as soon as everything they depend on is done.
+//
+// Background tasks go to the global thread pool and must not touch
+// QObjects; they hand results over through state the main-thread tasks
+// that depend on them read later. Main-thread tasks run inline. start()
+// launches every ready background task before running main-thread work, so
+// disk I/O overlaps with QML loading. Each task is timed into the trace.
+// Dependencies must name added tasks; start() aborts on an unknown one.
+class StartupPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Thread {
+        MainThread,
+        Background,
+    };
+
+    explicit StartupPipeline(StartupTrace& trace, QObject* parent = nullptr);
+
+    void add(const QString& name, const QStringList& dependsOn, Thread thread,
+             std::function<void()> task);
+    void start();
+
+signals:
+    void finished();
+
+private:
+    enum State { Pending, Running, Done };
+
+    struct Task {
+        QString name;
+        QStringList dependsOn;
+        Thread thread;
+        std::function<void()> run;
+        State state = Pending;
+    };
+
+    const Task* find(const QString& name) const;
+    bool isReady(const Task& task) const;
+    void schedule();
+    void complete(qsizetype index, qint64 beginNs, qint64 endNs);
+
+    StartupTrace& m_trace;
+    QList<Task>   m_tasks;
+    qsizetype     m_remaining = 0;
+};
+
+#endif // STARTUPPIPELINE_H
@@ -0,0 +1,74 @@
+#include "StartupTrace.h"
+#include <QDebug>
+#include <QSaveFile>
+#include "serialization/JsonWriter.h"
+
+StartupTrace::StartupTrace()
+{
+    m_clock.start();
+}
+
+void StartupTrace::record(const QString& phase, qint64 beginNs, qint64 endNs, bool background)
+{
+    m_entries.append(Entry{ phase, beginNs, endNs, background });
+}
+
+void StartupTrace::mark(const QString& event)
+{
+    const qint64 t = now();
+    m_entries.append(Entry{ event, t, t, false });
+}
+
+void StartupTrace::report() const
+{
+    const auto ms = [](qint64 ns) { return QString::number(double(ns) / 1e6, 'f', 1); };
+
+    qint64 end = 0;
+    for (const Entry& e : m_entries) {
+        end = qMax(end, e.endNs);
+        if (e.beginNs == e.endNs) {
+            qDebug().noquote() << "[Startup]" << ms(e.beginNs).rightJustified(8) << "ms " << e.name;
+        } else {
+            qDebug().noquote() << "[Startup]" << ms(e.beginNs).rightJustified(8) << "ms "
+                               << e.name << "took" << ms(e.endNs - e.beginNs) << "ms"
+                               << (e.background ? "(worker)" : "(main)");
+        }
+    }
+    qDebug().noquote() << "[Startup] interactive after" << ms(end) << "ms";
+
+    const QString path = qEnvironmentVariable("POCAUTH_STARTUP_TRACE");
+    if (!path.isEmpty() && !writeChromeTrace(path))
+        qWarning().noquote() << "[Startup] could not write trace to" << path;
+}
+
+bool StartupTrace::writeChromeTrace(const QString& path) const
+{
+    QByteArray out;
+    JsonWriter w(out);
+    w.beginArray();
+    for (const Entry& e : m_entries) {
+        const bool instant = e.beginNs == e.endNs;
+        w.beginObject();
+        w.key("name");
+        w.string(e.name);
+        w.key("ph");
+        w.string(instant ? u"i" : u"X");
+        w.key("ts");
+        w.number(e.beginNs / 1000);
+        if (!instant) {
+            w.key("dur");
+            w.number((e.endNs - e.beginNs) / 1000);
+        }
+        w.key("pid");
+        w.number(1);
+        w.key("tid");
+        w.number(e.background ? 2 : 1);
+        w.endObject();
+    }
+    w.endArray();
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(out);
+    return file.commit();
+}
@@ -0,0 +1,41 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+
+// Timeline of startup phases, measured from process start.
+//
+// now() may be called from any thread; record() and mark() only from the
+// main thread. report() logs every phase and, when the
+// POCAUTH_STARTUP_TRACE environment variable names a file, also writes
+// the timeline there in Chrome trace event format (chrome://tracing,
+// Perfetto).
+class StartupTrace
+{
+public:
+    StartupTrace();
+
+    qint64 now() const { return m_clock.nsecsElapsed(); }
+
+    void record(const QString& phase, qint64 beginNs, qint64 endNs, bool background);
+    void mark(const QString& event);
+
+    void report() const;
+
+private:
+    struct Entry {
+        QString name;
+        qint64 beginNs;
+        qint64 endNs;      // == beginNs for marks
+        bool background;
+    };
+
+    bool writeChromeTrace(const QString& path) const;
+
+    QElapsedTimer m_clock;
+    QList<Entry>  m_entries;
+};
+
+#endif // STARTUPTRACE_H
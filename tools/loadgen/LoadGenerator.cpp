@@ -0,0 +1,330 @@
+#include "LoadGenerator.h"
+#include <QDebug>
+#include <QRandomGenerator>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include "networking/ApiEndpoints.h"
+#include "serialization/JsonWriter.h"
+
+namespace {
+
+constexpr int DrainTimeoutMs = 10000;
+
+const char* const Statuses[] = { "active", "inactive", "maintenance" };
+
+} // namespace
+
+// LatencyStats
+
+void LatencyStats::add(qint64 us, bool ok)
+{
+    m_samples.push_back(us);
+    m_sorted = false;
+    if (!ok) ++m_errors;
+}
+
+qint64 LatencyStats::percentile(double p) const
+{
+    if (m_samples.empty()) return 0;
+    if (!m_sorted) {
+        std::sort(m_samples.begin(), m_samples.end());
+        m_sorted = true;
+    }
+    // Nearest-rank
+    const auto rank = qsizetype(std::ceil(p / 100.0 * double(m_samples.size())));
+    return m_samples[size_t(qBound<qsizetype>(1, rank, qsizetype(m_samples.size())) - 1)];
+}
+
+// VirtualUser
+
+const char* VirtualUser::opName(Op op)
+{
+    switch (op) {
+    case Login:   return "login";
+    case Refresh: return "refresh";
+    case List:    return "list";
+    case Create:  return "create";
+    case Update:  return "update";
+    case Remove:  return "delete";
+    case OpCount: break;
+    }
+    return "?";
+}
+
+VirtualUser::VirtualUser(int index, LoadGenerator* generator)
+    : QObject(generator)
+    , m_index(index)
+    , m_generator(generator)
+    , m_client(QUrl(generator->options().baseUrl), this)
+    , m_auth(&m_client, this)
+    , m_items(&m_client, this)
+{
+    const LoadOptions& o = generator->options();
+    m_intervalMs = qint64(std::llround(1000.0 * o.users / o.rate));
+
+    m_client.setDefaultRetryPolicy(RetryPolicy{ .maxAttempts = 1 + o.retries });
+    m_client.setTokenRefresher([this](std::function<void(bool)> done) {
+        refresh(std::move(done));
+    });
+
+    m_pace.setSingleShot(true);
+    connect(&m_pace, &QTimer::timeout, this, &VirtualUser::next);
+}
+
+void VirtualUser::start(int delayMs)
+{
+    QTimer::singleShot(delayMs, this, &VirtualUser::login);
+}
+
+void VirtualUser::stop()
+{
+    m_stopped = true;
+    m_pace.stop();
+}
+
+void VirtualUser::login()
+{
+    if (m_stopped) return;
+    const LoadOptions& o = m_generator->options();
+
+    m_busy = true;
+    m_opClock.start();
+    m_auth.login(o.username, o.password, [this](const LoginResult& result) {
+        m_client.setBearerToken(result.tokens.accessToken.toUtf8());
+        m_refreshToken = result.tokens.refreshToken;
+        finish(Login, true);
+    }, [this](const ErrorResult& err) {
+        qWarning().noquote() << "[LoadGen] user" << m_index << "login failed:" << err.message;
+        finish(Login, false);
+    });
+}
+
+void VirtualUser::next()
+{
+    if (m_stopped) return;
+    // Not logged in yet, or the session was lost
+    run(m_refreshToken.isEmpty() ? Login : pick());
+}
+
+VirtualUser::Op VirtualUser::pick() const
+{
+    const LoadOptions& o = m_generator->options();
+    const int weights[] = { 0, o.refreshWeight, o.listWeight, o.createWeight,
+                            m_ownItems.isEmpty() ? 0 : o.updateWeight,
+                            m_ownItems.isEmpty() ? 0 : o.removeWeight };
+    int total = 0;
+    for (int w : weights) total += w;
+    if (total <= 0) return List;
+
+    int roll = QRandomGenerator::global()->bounded(total);
+    for (int op = 0; op < OpCount; ++op) {
+        if (roll < weights[op]) return Op(op);
+        roll -= weights[op];
+    }
+    return List;
+}
+
+void VirtualUser::run(Op op)
+{
+    m_busy = true;
+    m_opClock.start();
+
+    const auto fail = [this, op](const ErrorResult& err) {
+        qDebug().noquote() << "[LoadGen] user" << m_index << opName(op) << "failed:" << err.message;
+        finish(op, false);
+    };
+
+    switch (op) {
+    case Login:
+        login();
+        break;
+    case Refresh:
+        refresh([this](bool ok) { finish(Refresh, ok); });
+        break;
+    case List:
+        m_items.fetchAll([this](ItemStore&&) { finish(List, true); }, fail);
+        break;
+    case Create: {
+        const QString name = QStringLiteral("loadgen %1-%2").arg(m_index).arg(++m_created);
+        const char* status = Statuses[m_created % std::size(Statuses)];
+        m_items.create(name, QString::fromLatin1(status), [this](Item&& item) {
+            m_ownItems.append(std::move(item.id));
+            finish(Create, true);
+        }, fail);
+        break;
+    }
+    case Update: {
+        const QString& id = m_ownItems.at(QRandomGenerator::global()->bounded(m_ownItems.size()));
+        m_items.update(id, QStringLiteral("loadgen %1 renamed").arg(m_index),
+                       [this](Item&&) { finish(Update, true); }, fail);
+        break;
+    }
+    case Remove: {
+        const QString id = m_ownItems.takeAt(QRandomGenerator::global()->bounded(m_ownItems.size()));
+        m_items.remove(id, [this] { finish(Remove, true); }, fail);
+        break;
+    }
+    case OpCount:
+        break;
+    }
+}
+
+void VirtualUser::refresh(std::function<void(bool)> done)
+{
+    // Also reached from HttpClient after a 401; that time counts towards
+    // the operation that got the 401
+    m_auth.refresh(m_refreshToken, [this, done](const LoginResult& result) {
+        m_client.setBearerToken(result.tokens.accessToken.toUtf8());
+        m_refreshToken = result.tokens.refreshToken;
+        done(true);
+    }, [this, done](const ErrorResult& err) {
+        qDebug().noquote() << "[LoadGen] user" << m_index << "refresh failed:" << err.message;
+        // Log in again on the next turn
+        m_refreshToken.clear();
+        done(false);
+    });
+}
+
+void VirtualUser::finish(Op op, bool ok)
+{
+    m_generator->record(op, m_opClock.nsecsElapsed() / 1000, ok);
+    m_busy = false;
+    if (m_stopped) return;
+
+    const qint64 wait = qMax<qint64>(0, m_intervalMs - m_opClock.elapsed());
+    m_pace.start(int(wait));
+}
+
+// LoadGenerator
+
+LoadGenerator::LoadGenerator(const LoadOptions& options, QObject* parent)
+    : QObject(parent)
+    , m_options(options)
+{
+    ApiEndpoints::BaseUrl = m_options.baseUrl;
+
+    for (int i = 0; i < m_options.users; ++i)
+        m_users.append(new VirtualUser(i, this));
+
+    m_progress.setInterval(m_options.reportEverySec * 1000);
+    connect(&m_progress, &QTimer::timeout, this, &LoadGenerator::progress);
+}
+
+void LoadGenerator::start()
+{
+    qInfo().noquote() << "[LoadGen]" << m_options.users << "users," << m_options.rate << "ops/s for"
+                      << m_options.durationSec << "s against" << m_options.baseUrl;
+
+    // Logins are spread over one pacing interval instead of arriving at once
+    const double intervalMs = 1000.0 * m_options.users / m_options.rate;
+    for (int i = 0; i < m_users.size(); ++i)
+        m_users[i]->start(int(intervalMs * i / m_users.size()));
+
+    m_clock.start();
+    if (m_options.reportEverySec > 0)
+        m_progress.start();
+    QTimer::singleShot(m_options.durationSec * 1000, this, &LoadGenerator::stop);
+}
+
+void LoadGenerator::record(VirtualUser::Op op, qint64 us, bool ok)
+{
+    m_stats[op].add(us, ok);
+}
+
+void LoadGenerator::progress()
+{
+    qint64 count = 0;
+    qint64 errors = 0;
+    for (const LatencyStats& s : m_stats) {
+        count += s.count();
+        errors += s.errors();
+    }
+    const double seconds = m_options.reportEverySec;
+    qInfo().noquote() << QStringLiteral("[LoadGen] %1 s: %2 ops (%3/s), %4 errors")
+                             .arg(m_clock.elapsed() / 1000)
+                             .arg(count)
+                             .arg(double(count - m_lastCount) / seconds, 0, 'f', 1)
+                             .arg(errors);
+    m_lastCount = count;
+}
+
+void LoadGenerator::stop()
+{
+    m_elapsedMs = m_clock.elapsed();
+    m_progress.stop();
+    for (VirtualUser* user : std::as_const(m_users))
+        user->stop();
+    drain();
+}
+
+void LoadGenerator::drain()
+{
+    // Operations still in flight are recorded, up to a bound
+    const bool pending = std::any_of(m_users.cbegin(), m_users.cend(),
+                                     [](const VirtualUser* u) { return u->busy(); });
+    if (pending && m_clock.elapsed() - m_elapsedMs < DrainTimeoutMs) {
+        QTimer::singleShot(50, this, &LoadGenerator::drain);
+        return;
+    }
+    emit finished();
+}
+
+QString LoadGenerator::textReport() const
+{
+    const double seconds = qMax<qint64>(1, m_elapsedMs) / 1000.0;
+    QString out = QStringLiteral("%1 %2 %3 %4 %5 %6 %7 %8\n")
+                      .arg(u"op", -8).arg(u"count", 8).arg(u"errors", 7).arg(u"ops/s", 8)
+                      .arg(u"p50 ms", 8).arg(u"p90 ms", 8).arg(u"p99 ms", 8).arg(u"max ms", 8);
+
+    for (int op = 0; op < VirtualUser::OpCount; ++op) {
+        const LatencyStats& s = m_stats[op];
+        if (s.count() == 0) continue;
+        out += QStringLiteral("%1 %2 %3 %4 %5 %6 %7 %8\n")
+                   .arg(QLatin1StringView(VirtualUser::opName(VirtualUser::Op(op))), -8)
+                   .arg(s.count(), 8)
+                   .arg(s.errors(), 7)
+                   .arg(double(s.count()) / seconds, 8, 'f', 1)
+                   .arg(s.percentile(50) / 1000.0, 8, 'f', 1)
+                   .arg(s.percentile(90) / 1000.0, 8, 'f', 1)
+                   .arg(s.percentile(99) / 1000.0, 8, 'f', 1)
+                   .arg(s.max() / 1000.0, 8, 'f', 1);
+    }
+    return out;
+}
+
+QByteArray LoadGenerator::jsonReport() const
+{
+    QByteArray out;
+    JsonWriter w(out);
+    w.beginObject();
+    w.key("users");
+    w.number(m_options.users);
+    w.key("targetRate");
+    w.real(m_options.rate);
+    w.key("elapsedMs");
+    w.number(m_elapsedMs);
+    w.key("operations");
+    w.beginObject();
+    for (int op = 0; op < VirtualUser::OpCount; ++op) {
+        const LatencyStats& s = m_stats[op];
+        w.key(VirtualUser::opName(VirtualUser::Op(op)));
+        w.beginObject();
+        w.key("count");
+        w.number(s.count());
+        w.key("errors");
+        w.number(s.errors());
+        w.key("p50Us");
+        w.number(s.percentile(50));
+        w.key("p90Us");
+        w.number(s.percentile(90));
+        w.key("p99Us");
+        w.number(s.percentile(99));
+        w.key("maxUs");
+        w.number(s.max());
+        w.endObject();
+    }
+    w.endObject();
+    w.endObject();
+    return out;
+}
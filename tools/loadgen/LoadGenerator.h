@@ -0,0 +1,148 @@
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <array>
+#include <vector>
+#include "networking/AuthApi.h"
+#include "networking/HttpClient.h"
+#include "networking/ItemApi.h"
+
+struct LoadOptions
+{
+    QString baseUrl = "http://localhost:7000";
+    QString username = "editor";
+    QString password = "editor";
+    int     users = 10;
+    double  rate = 50;            // operations per second over all users
+    int     durationSec = 30;
+    int     retries = 0;          // extra GET attempts, on top of the first
+    int     reportEverySec = 5;
+
+    // Relative weights of the operations a user picks after logging in
+    int     listWeight = 40;
+    int     createWeight = 20;
+    int     updateWeight = 20;
+    int     removeWeight = 10;
+    int     refreshWeight = 10;
+};
+
+// Latency samples of one operation, in microseconds
+class LatencyStats
+{
+public:
+    void add(qint64 us, bool ok);
+
+    qint64 count() const { return qint64(m_samples.size()); }
+    qint64 errors() const { return m_errors; }
+
+    // `p` in 0..100; sorts the samples on first use after an add()
+    qint64 percentile(double p) const;
+    qint64 max() const { return percentile(100); }
+
+private:
+    mutable std::vector<qint64> m_samples;
+    mutable bool                m_sorted = true;
+    qint64                      m_errors = 0;
+};
+
+class LoadGenerator;
+
+// One simulated client: its own HttpClient, AuthApi and ItemApi, a session
+// obtained by logging in, and the items it has created so far. A 401 goes
+// through HttpClient's token refresher like in the app.
+class VirtualUser : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Op {
+        Login = 0,
+        Refresh,
+        List,
+        Create,
+        Update,
+        Remove,
+        OpCount
+    };
+
+    static const char* opName(Op op);
+
+    VirtualUser(int index, LoadGenerator* generator);
+
+    void start(int delayMs);
+    void stop();
+    bool busy() const { return m_busy; }
+
+private:
+    void login();
+    void next();
+    void run(Op op);
+    void refresh(std::function<void(bool)> done);
+    void finish(Op op, bool ok);
+    Op pick() const;
+
+    int             m_index;
+    LoadGenerator*  m_generator;
+    HttpClient      m_client;
+    AuthApi         m_auth;
+    ItemApi         m_items;
+
+    QString         m_refreshToken;
+    QStringList     m_ownItems;
+    int             m_created = 0;
+
+    QTimer          m_pace;
+    QElapsedTimer   m_opClock;
+    qint64          m_intervalMs = 0;
+    bool            m_busy = false;
+    bool            m_stopped = false;
+};
+
+// Drives LoadOptions::users VirtualUsers at LoadOptions::rate for
+// LoadOptions::durationSec, then waits for in-flight operations and emits
+// finished(). Pacing is closed-loop per user: each user starts its next
+// operation one interval after the previous one started, or right away
+// when the server is slower than that.
+class LoadGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LoadGenerator(const LoadOptions& options, QObject* parent = nullptr);
+
+    const LoadOptions& options() const { return m_options; }
+
+    void start();
+    void record(VirtualUser::Op op, qint64 us, bool ok);
+
+    const LatencyStats& stats(VirtualUser::Op op) const { return m_stats[op]; }
+    qint64 elapsedMs() const { return m_elapsedMs; }
+
+    QString textReport() const;
+    QByteArray jsonReport() const;
+
+signals:
+    void finished();
+
+private:
+    void progress();
+    void stop();
+    void drain();
+
+    LoadOptions                 m_options;
+    QList<VirtualUser*>         m_users;
+    std::array<LatencyStats, VirtualUser::OpCount> m_stats;
+
+    QElapsedTimer               m_clock;
+    qint64                      m_elapsedMs = 0;
+    QTimer                      m_progress;
+    qint64                      m_lastCount = 0;
+};
+
+#endif // LOADGENERATOR_H
@@ -0,0 +1,113 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QLoggingCategory>
+#include <QTextStream>
+#include "LoadGenerator.h"
+
+namespace {
+
+bool parseInt(const QCommandLineParser& parser, const QString& option, int& out, int min)
+{
+    if (!parser.isSet(option)) return true;
+    bool ok = false;
+    out = parser.value(option).toInt(&ok);
+    if (ok && out >= min) return true;
+    qCritical().noquote() << "[LoadGen] --" + option << "expects an integer >=" << min;
+    return false;
+}
+
+bool parseMix(const QString& spec, LoadOptions& o)
+{
+    // list:create:update:delete:refresh
+    const QStringList parts = spec.split(u':');
+    if (parts.size() != 5) return false;
+
+    int* const weights[] = { &o.listWeight, &o.createWeight, &o.updateWeight,
+                             &o.removeWeight, &o.refreshWeight };
+    for (int i = 0; i < 5; ++i) {
+        bool ok = false;
+        *weights[i] = parts[i].toInt(&ok);
+        if (!ok || *weights[i] < 0) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("PoCLoadGen");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Load generator driving the PoC REST API through the client's own AuthApi,\n"
+        "ItemApi and HttpClient. Each virtual user logs in, then runs a weighted mix\n"
+        "of item CRUD and token refreshes.");
+    parser.addHelpOption();
+    parser.addOptions({
+        { "url", "Server base URL.", "url", "http://localhost:7000" },
+        { { "u", "users" }, "Concurrent virtual users.", "n", "10" },
+        { { "r", "rate" }, "Target operations per second over all users.", "ops", "50" },
+        { { "d", "duration" }, "Seconds to run.", "seconds", "30" },
+        { "username", "Login name every user signs in with.", "name", "editor" },
+        { "password", "Password for --username.", "password", "editor" },
+        { "mix", "Weights list:create:update:delete:refresh.", "weights", "40:20:20:10:10" },
+        { "retries", "Extra attempts for failed GETs.", "n", "0" },
+        { "report-every", "Seconds between progress lines; 0 for none.", "seconds", "5" },
+        { "json", "Also write the report as JSON to this file ('-' for stdout).", "file" },
+        { "verbose", "Keep the client's debug logging." },
+    });
+    parser.process(app);
+
+    LoadOptions o;
+    o.baseUrl = parser.value("url");
+    o.username = parser.value("username");
+    o.password = parser.value("password");
+
+    bool ok = false;
+    o.rate = parser.value("rate").toDouble(&ok);
+    if (!ok || o.rate <= 0) {
+        qCritical() << "[LoadGen] --rate expects a positive number";
+        return 1;
+    }
+    if (!parseMix(parser.value("mix"), o)) {
+        qCritical() << "[LoadGen] --mix expects five non-negative weights, e.g. 40:20:20:10:10";
+        return 1;
+    }
+    if (!parseInt(parser, "users", o.users, 1)
+        || !parseInt(parser, "duration", o.durationSec, 1)
+        || !parseInt(parser, "retries", o.retries, 0)
+        || !parseInt(parser, "report-every", o.reportEverySec, 0)) {
+        return 1;
+    }
+
+    // Per-request client logging would swamp the report and skew timings
+    if (!parser.isSet("verbose"))
+        QLoggingCategory::setFilterRules("*.debug=false");
+
+    LoadGenerator generator(o);
+    QObject::connect(&generator, &LoadGenerator::finished, &app, [&]() {
+        QTextStream(stdout) << generator.textReport();
+
+        if (parser.isSet("json")) {
+            const QString path = parser.value("json");
+            QFile file(path);
+            const bool opened = path == u"-" ? file.open(stdout, QIODevice::WriteOnly)
+                                             : file.open(QIODevice::WriteOnly);
+            if (!opened) {
+                qCritical().noquote() << "[LoadGen] cannot write" << path;
+                QCoreApplication::exit(1);
+                return;
+            }
+            file.write(generator.jsonReport());
+            file.write("\n");
+        }
+        QCoreApplication::quit();
+    });
+    generator.start();
+
+    return app.exec();
+}
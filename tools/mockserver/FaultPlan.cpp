@@ -0,0 +1,218 @@
+#include "FaultPlan.h"
+#include <QFileInfo>
+#include <QSettings>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// QSettings splits unquoted commas into a list; latency specs use them
+QString readText(const QSettings& ini, const QString& key)
+{
+    const QVariant v = ini.value(key);
+    return v.typeId() == QMetaType::QStringList ? v.toStringList().join(u',') : v.toString();
+}
+
+bool readRate(const QSettings& ini, const QString& key, double& out, QString& error)
+{
+    if (!ini.contains(key)) return true;
+    bool ok = false;
+    const double v = readText(ini, key).toDouble(&ok);
+    if (!ok || v < 0.0 || v > 1.0) {
+        error = QStringLiteral("%1: expected a rate between 0 and 1").arg(key);
+        return false;
+    }
+    out = v;
+    return true;
+}
+
+bool readCount(const QSettings& ini, const QString& key, int& out, QString& error)
+{
+    if (!ini.contains(key)) return true;
+    bool ok = false;
+    const int v = readText(ini, key).toInt(&ok);
+    if (!ok || v < 0) {
+        error = QStringLiteral("%1: expected a non-negative integer").arg(key);
+        return false;
+    }
+    out = v;
+    return true;
+}
+
+// Reads the keys present in the current group over `faults`
+bool readFaults(const QSettings& ini, RouteFaults& faults, QString& error)
+{
+    if (ini.contains("latency")) {
+        const QString spec = readText(ini, "latency");
+        const auto latency = LatencyModel::parse(spec);
+        if (!latency) {
+            error = QStringLiteral("latency: cannot parse \"%1\"").arg(spec);
+            return false;
+        }
+        faults.latency = *latency;
+    }
+    return readRate(ini, "unauthorizedRate", faults.unauthorizedRate, error)
+        && readRate(ini, "throttleRate", faults.throttleRate, error)
+        && readRate(ini, "unavailableRate", faults.unavailableRate, error)
+        && readRate(ini, "errorRate", faults.errorRate, error)
+        && readCount(ini, "retryAfterSec", faults.retryAfterSec, error)
+        && readCount(ini, "dripBytes", faults.dripBytes, error)
+        && readCount(ini, "dripIntervalMs", faults.dripIntervalMs, error);
+}
+
+} // namespace
+
+std::optional<LatencyModel> LatencyModel::parse(QStringView spec)
+{
+    spec = spec.trimmed();
+    if (spec.isEmpty() || spec == u"none")
+        return LatencyModel{};
+
+    const qsizetype colon = spec.indexOf(u':');
+    if (colon < 0) return std::nullopt;
+
+    const QStringView name = spec.first(colon);
+    const auto params = spec.sliced(colon + 1).split(u',');
+
+    LatencyModel m;
+    bool ok = true;
+    if (name == u"fixed") m.kind = Fixed;
+    else if (name == u"uniform") m.kind = Uniform;
+    else if (name == u"normal") m.kind = Normal;
+    else if (name == u"exp") m.kind = Exponential;
+    else return std::nullopt;
+
+    const qsizetype expected = (m.kind == Uniform || m.kind == Normal) ? 2 : 1;
+    if (params.size() != expected) return std::nullopt;
+
+    m.a = params[0].trimmed().toDouble(&ok);
+    if (!ok || m.a < 0) return std::nullopt;
+    if (expected == 2) {
+        m.b = params[1].trimmed().toDouble(&ok);
+        if (!ok || m.b < 0) return std::nullopt;
+    }
+    if (m.kind == Uniform && m.b < m.a) return std::nullopt;
+    if (m.kind == Exponential && m.a == 0) m.kind = None;
+    // std::normal_distribution needs a positive deviation
+    if (m.kind == Normal && m.b == 0) m.kind = Fixed;
+    return m;
+}
+
+QString LatencyModel::toString() const
+{
+    switch (kind) {
+    case Fixed:       return QStringLiteral("fixed:%1").arg(a);
+    case Uniform:     return QStringLiteral("uniform:%1,%2").arg(a).arg(b);
+    case Normal:      return QStringLiteral("normal:%1,%2").arg(a).arg(b);
+    case Exponential: return QStringLiteral("exp:%1").arg(a);
+    case None:        break;
+    }
+    return QStringLiteral("none");
+}
+
+int LatencyModel::sample(std::mt19937_64& rng) const
+{
+    double ms = 0;
+    switch (kind) {
+    case None:
+        return 0;
+    case Fixed:
+        ms = a;
+        break;
+    case Uniform:
+        ms = std::uniform_real_distribution<double>(a, b)(rng);
+        break;
+    case Normal:
+        ms = std::normal_distribution<double>(a, b)(rng);
+        break;
+    case Exponential:
+        ms = std::exponential_distribution<double>(1.0 / a)(rng);
+        break;
+    }
+    return int(std::lround(std::clamp(ms, 0.0, 600000.0)));
+}
+
+const char* FaultPlan::routeName(Route route)
+{
+    switch (route) {
+    case Login:      return "login";
+    case Refresh:    return "refresh";
+    case Logout:     return "logout";
+    case ListItems:  return "items.list";
+    case CreateItem: return "items.create";
+    case UpdateItem: return "items.update";
+    case DeleteItem: return "items.delete";
+    case RouteCount: break;
+    }
+    return "?";
+}
+
+FaultPlan::FaultPlan(quint64 seed)
+    : m_rng(seed)
+{
+}
+
+void FaultPlan::setDefaults(const RouteFaults& faults)
+{
+    m_routes.fill(faults);
+}
+
+bool FaultPlan::loadScenario(const QString& path, QString& error)
+{
+    if (!QFileInfo::exists(path)) {
+        error = QStringLiteral("%1: no such file").arg(path);
+        return false;
+    }
+
+    QSettings ini(path, QSettings::IniFormat);
+    if (ini.status() != QSettings::NoError) {
+        error = QStringLiteral("%1: not a valid INI file").arg(path);
+        return false;
+    }
+
+    // Nothing is applied unless the whole file parses
+    RouteFaults base = m_routes[Login];
+    ini.beginGroup("default");
+    const bool baseOk = readFaults(ini, base, error);
+    ini.endGroup();
+    if (!baseOk) {
+        error.prepend(QStringLiteral("%1 [default] ").arg(path));
+        return false;
+    }
+
+    std::array<RouteFaults, RouteCount> routes;
+    for (int r = 0; r < RouteCount; ++r) {
+        routes[r] = base;
+        ini.beginGroup(routeName(Route(r)));
+        const bool ok = readFaults(ini, routes[r], error);
+        ini.endGroup();
+        if (!ok) {
+            error.prepend(QStringLiteral("%1 [%2] ").arg(path, routeName(Route(r))));
+            return false;
+        }
+    }
+    m_routes = routes;
+    return true;
+}
+
+FaultPlan::Fault FaultPlan::roll(Route route)
+{
+    const RouteFaults& f = m_routes[route];
+    double u = std::uniform_real_distribution<double>(0.0, 1.0)(m_rng);
+
+    if (needsToken(route)) {
+        if (u < f.unauthorizedRate) return InjectUnauthorized;
+        u -= f.unauthorizedRate;
+    }
+    if (u < f.throttleRate) return InjectThrottle;
+    u -= f.throttleRate;
+    if (u < f.unavailableRate) return InjectUnavailable;
+    u -= f.unavailableRate;
+    if (u < f.errorRate) return InjectError;
+    return NoFault;
+}
+
+int FaultPlan::latencyMs(Route route)
+{
+    return m_routes[route].latency.sample(m_rng);
+}
@@ -0,0 +1,101 @@
+#ifndef FAULTPLAN_H
+#define FAULTPLAN_H
+
+#include <QString>
+#include <QStringView>
+#include <array>
+#include <optional>
+#include <random>
+
+// Response delay in milliseconds, drawn per request.
+//
+//   fixed:50           always 50
+//   uniform:10,200     evenly between 10 and 200
+//   normal:80,20       mean 80, standard deviation 20 (clamped at 0); SD 0 is fixed
+//   exp:40             exponential with mean 40
+struct LatencyModel
+{
+    enum Kind {
+        None = 0,
+        Fixed,
+        Uniform,
+        Normal,
+        Exponential,
+    };
+
+    Kind   kind = None;
+    double a = 0;
+    double b = 0;
+
+    static std::optional<LatencyModel> parse(QStringView spec);
+    QString toString() const;
+
+    int sample(std::mt19937_64& rng) const;
+};
+
+// What can go wrong on one route. Rates are probabilities in 0..1 and are
+// rolled in the order 401, 429, 503, 500 from a single draw, so they add up.
+struct RouteFaults
+{
+    LatencyModel latency;
+    double unauthorizedRate = 0;   // only on routes that need a token
+    double throttleRate = 0;       // 429 with Retry-After
+    double unavailableRate = 0;    // 503 with Retry-After
+    double errorRate = 0;          // 500
+    int    retryAfterSec = 1;
+
+    // Body sent dripBytes at a time, dripIntervalMs apart; 0 sends it whole
+    int    dripBytes = 0;
+    int    dripIntervalMs = 0;
+};
+
+// Per-route fault settings plus the seeded generator they are rolled with.
+// A fixed seed makes a run reproducible request for request.
+//
+// Scenario files are INI: [default] overrides the command line for every
+// route and [login], [refresh], [logout], [items.list], [items.create],
+// [items.update], [items.delete] override [default] for one route. Keys
+// match RouteFaults: latency, unauthorizedRate, throttleRate,
+// unavailableRate, errorRate, retryAfterSec, dripBytes, dripIntervalMs.
+class FaultPlan
+{
+public:
+    enum Route {
+        Login = 0,
+        Refresh,
+        Logout,
+        ListItems,
+        CreateItem,
+        UpdateItem,
+        DeleteItem,
+        RouteCount
+    };
+
+    enum Fault {
+        NoFault = 0,
+        InjectUnauthorized,
+        InjectThrottle,
+        InjectUnavailable,
+        InjectError,
+    };
+
+    static const char* routeName(Route route);
+    static bool needsToken(Route route) { return route >= Logout; }
+
+    explicit FaultPlan(quint64 seed = std::random_device{}());
+
+    // Applies `faults` to every route, discarding per-route settings
+    void setDefaults(const RouteFaults& faults);
+    bool loadScenario(const QString& path, QString& error);
+
+    const RouteFaults& faults(Route route) const { return m_routes[route]; }
+
+    Fault roll(Route route);
+    int latencyMs(Route route);
+
+private:
+    std::array<RouteFaults, RouteCount> m_routes;
+    std::mt19937_64 m_rng;
+};
+
+#endif // FAULTPLAN_H
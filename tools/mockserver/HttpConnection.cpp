@@ -0,0 +1,198 @@
+#include "HttpConnection.h"
+#include <QTcpSocket>
+
+namespace {
+
+constexpr qsizetype MaxHeaderBytes = 64 * 1024;
+constexpr qsizetype MaxBodyBytes = 64 * 1024 * 1024;
+
+const char* reasonPhrase(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 201: return "Created";
+    case 204: return "No Content";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Content Too Large";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    default:  return "Unknown";
+    }
+}
+
+} // namespace
+
+QByteArray HttpRequest::header(QByteArrayView name) const
+{
+    for (const auto& [key, value] : headers) {
+        if (key == name) return value;
+    }
+    return {};
+}
+
+HttpConnection::HttpConnection(QTcpSocket* socket, QObject* parent)
+    : QObject(parent)
+    , m_socket(socket)
+{
+    m_socket->setParent(this);
+    connect(m_socket, &QTcpSocket::readyRead, this, &HttpConnection::readRequests);
+    connect(m_socket, &QTcpSocket::disconnected, this, &QObject::deleteLater);
+    connect(&m_drip, &QTimer::timeout, this, &HttpConnection::writeChunk);
+}
+
+void HttpConnection::respond(HttpResponse response, int delayMs, int dripBytes, int dripIntervalMs)
+{
+    QTimer::singleShot(delayMs, this, [this, response = std::move(response), dripBytes, dripIntervalMs] {
+        writeHead(response);
+        if (dripBytes <= 0 || response.body.size() <= dripBytes) {
+            m_socket->write(response.body);
+            finishResponse();
+            return;
+        }
+        m_body = response.body;
+        m_bodyOffset = 0;
+        m_dripBytes = dripBytes;
+        m_drip.start(dripIntervalMs);
+        writeChunk();
+    });
+}
+
+void HttpConnection::readRequests()
+{
+    m_buffer.append(m_socket->readAll());
+    if (m_busy) return;
+
+    HttpRequest request;
+    bool complete = false;
+    if (!parseRequest(request, complete) || !complete) return;
+
+    m_busy = true;
+    emit requestReceived(this, request);
+}
+
+bool HttpConnection::parseRequest(HttpRequest& request, bool& complete)
+{
+    const qsizetype headEnd = m_buffer.indexOf("\r\n\r\n");
+    if (headEnd < 0) {
+        if (m_buffer.size() > MaxHeaderBytes) {
+            reject(431);
+            return false;
+        }
+        return true;
+    }
+
+    const QList<QByteArray> lines = m_buffer.first(headEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() != 3 || !requestLine[2].startsWith("HTTP/1.")) {
+        reject(400);
+        return false;
+    }
+
+    request.method = requestLine[0];
+    request.path = requestLine[1];
+    if (const qsizetype q = request.path.indexOf('?'); q >= 0)
+        request.path.truncate(q);
+    m_keepAlive = requestLine[2] != "HTTP/1.0";
+
+    qsizetype contentLength = 0;
+    for (qsizetype i = 1; i < lines.size(); ++i) {
+        const QByteArray& line = lines[i];
+        const qsizetype colon = line.indexOf(':');
+        if (colon <= 0) {
+            reject(400);
+            return false;
+        }
+        QByteArray name = line.first(colon).trimmed().toLower();
+        QByteArray value = line.sliced(colon + 1).trimmed();
+
+        if (name == "content-length") {
+            bool ok = false;
+            contentLength = value.toLongLong(&ok);
+            if (!ok || contentLength < 0) {
+                reject(400);
+                return false;
+            }
+        } else if (name == "transfer-encoding") {
+            reject(501);
+            return false;
+        } else if (name == "connection") {
+            const QByteArray v = value.toLower();
+            if (v == "close") m_keepAlive = false;
+            else if (v == "keep-alive") m_keepAlive = true;
+        }
+        request.headers.append({ std::move(name), std::move(value) });
+    }
+
+    if (contentLength > MaxBodyBytes) {
+        reject(413);
+        return false;
+    }
+
+    const qsizetype total = headEnd + 4 + contentLength;
+    if (m_buffer.size() < total) return true;
+
+    request.body = m_buffer.sliced(headEnd + 4, contentLength);
+    m_buffer.remove(0, total);
+    complete = true;
+    return true;
+}
+
+void HttpConnection::writeHead(const HttpResponse& response)
+{
+    QByteArray head;
+    head.reserve(256);
+    head += "HTTP/1.1 " + QByteArray::number(response.status) + ' '
+          + reasonPhrase(response.status) + "\r\n";
+    if (response.status != 204) {
+        head += "Content-Type: application/json\r\n";
+        head += "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n";
+    }
+    head += m_keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    for (const auto& [name, value] : response.headers)
+        head += name + ": " + value + "\r\n";
+    head += "\r\n";
+    m_socket->write(head);
+}
+
+void HttpConnection::writeChunk()
+{
+    const qsizetype n = qMin<qsizetype>(m_dripBytes, m_body.size() - m_bodyOffset);
+    m_socket->write(m_body.constData() + m_bodyOffset, n);
+    m_bodyOffset += n;
+    if (m_bodyOffset < m_body.size()) return;
+
+    m_drip.stop();
+    m_body.clear();
+    finishResponse();
+}
+
+void HttpConnection::finishResponse()
+{
+    m_busy = false;
+    if (!m_keepAlive) {
+        m_socket->disconnectFromHost();
+        return;
+    }
+    // A pipelined request may already be buffered
+    if (!m_buffer.isEmpty())
+        QMetaObject::invokeMethod(this, &HttpConnection::readRequests, Qt::QueuedConnection);
+}
+
+void HttpConnection::reject(int status)
+{
+    m_keepAlive = false;
+    m_buffer.clear();
+
+    HttpResponse response;
+    response.status = status;
+    response.body = QByteArray(R"({"error":")") + reasonPhrase(status) + "\"}";
+    writeHead(response);
+    m_socket->write(response.body);
+    m_socket->disconnectFromHost();
+}
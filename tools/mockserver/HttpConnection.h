@@ -0,0 +1,68 @@
+#ifndef HTTPCONNECTION_H
+#define HTTPCONNECTION_H
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+#include <utility>
+
+class QTcpSocket;
+
+struct HttpRequest
+{
+    QByteArray method;
+    QByteArray path;                                  // without the query
+    QList<std::pair<QByteArray, QByteArray>> headers; // names lower-cased
+    QByteArray body;
+
+    QByteArray header(QByteArrayView name) const;
+};
+
+struct HttpResponse
+{
+    int status = 200;
+    QList<std::pair<QByteArray, QByteArray>> headers;
+    QByteArray body;                                  // sent as application/json
+};
+
+// One keep-alive HTTP/1.1 client connection.
+//
+// Only what QNetworkAccessManager sends is understood: a request line,
+// headers and a Content-Length body. Requests are answered strictly in
+// order; a pipelined request is not parsed until the previous response
+// has been fully written, however slowly it drips out.
+class HttpConnection : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HttpConnection(QTcpSocket* socket, QObject* parent = nullptr);
+
+    // Writes `response` after `delayMs`. With `dripBytes` > 0 the body goes
+    // out in chunks of that size, `dripIntervalMs` apart.
+    void respond(HttpResponse response, int delayMs = 0, int dripBytes = 0, int dripIntervalMs = 0);
+
+signals:
+    void requestReceived(HttpConnection* connection, const HttpRequest& request);
+
+private:
+    void readRequests();
+    bool parseRequest(HttpRequest& request, bool& complete);
+    void writeHead(const HttpResponse& response);
+    void writeChunk();
+    void finishResponse();
+    void reject(int status);
+
+    QTcpSocket* m_socket;
+    QByteArray  m_buffer;
+    bool        m_busy = false;
+    bool        m_keepAlive = true;
+
+    QByteArray  m_body;
+    qsizetype   m_bodyOffset = 0;
+    int         m_dripBytes = 0;
+    QTimer      m_drip;
+};
+
+#endif // HTTPCONNECTION_H
@@ -0,0 +1,437 @@
+#include "MockServer.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QMessageAuthenticationCode>
+#include <QRandomGenerator>
+#include <QSslServer>
+#include <QTcpSocket>
+#include <iterator>
+#include <optional>
+#include "entities/JwtClaims.h"
+#include "entities/UserSession.h"
+
+namespace {
+
+struct LoginBody
+{
+    QString username;
+    QString password;
+};
+
+struct RefreshBody
+{
+    QString refreshToken;
+};
+
+struct ItemBody
+{
+    QString name;
+    QString status;
+};
+
+} // namespace
+
+template<>
+struct JsonCodec::Fields<LoginBody> {
+    static constexpr auto list = std::tuple{
+        JsonCodec::field("username", &LoginBody::username),
+        JsonCodec::field("password", &LoginBody::password),
+    };
+};
+
+template<>
+struct JsonCodec::Fields<RefreshBody> {
+    static constexpr auto list = std::tuple{
+        JsonCodec::field("refreshToken", &RefreshBody::refreshToken),
+    };
+};
+
+template<>
+struct JsonCodec::Fields<ItemBody> {
+    static constexpr auto list = std::tuple{
+        JsonCodec::field("name",   &ItemBody::name),
+        JsonCodec::field("status", &ItemBody::status),
+    };
+};
+
+namespace {
+
+constexpr QByteArrayView ItemsPath = "/api/items";
+
+const char* const Statuses[] = { "active", "inactive", "maintenance" };
+
+QByteArray base64Url(const QByteArray& data)
+{
+    return data.toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
+}
+
+// Route for `request`; `itemId` is set for /api/items/<id>
+std::optional<FaultPlan::Route> matchRoute(const HttpRequest& request, int& itemId)
+{
+    const QByteArray& m = request.method;
+    const QByteArray& path = request.path;
+
+    if (m == "POST") {
+        if (path == "/auth/login") return FaultPlan::Login;
+        if (path == "/auth/refresh") return FaultPlan::Refresh;
+        if (path == "/auth/logout") return FaultPlan::Logout;
+    }
+
+    if (path == ItemsPath) {
+        if (m == "GET") return FaultPlan::ListItems;
+        if (m == "POST") return FaultPlan::CreateItem;
+        return std::nullopt;
+    }
+
+    if (path.startsWith(ItemsPath) && path.at(ItemsPath.size()) == '/') {
+        bool ok = false;
+        itemId = path.sliced(ItemsPath.size() + 1).toInt(&ok);
+        if (!ok) return std::nullopt;
+        if (m == "PUT" || m == "PATCH") return FaultPlan::UpdateItem;
+        if (m == "DELETE") return FaultPlan::DeleteItem;
+    }
+    return std::nullopt;
+}
+
+} // namespace
+
+MockServer::MockServer(const Options& options, FaultPlan* plan, QObject* parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_plan(plan)
+{
+    if (m_options.tls.isNull()) {
+        m_server = new QTcpServer(this);
+    } else {
+        auto* server = new QSslServer(this);
+        server->setSslConfiguration(m_options.tls);
+        // Typically a client that does not trust the certificate yet
+        connect(server, &QSslServer::errorOccurred, this, [](QSslSocket* socket, QAbstractSocket::SocketError) {
+            qWarning().noquote() << "[MockServer] TLS handshake failed:" << socket->errorString();
+        });
+        m_server = server;
+    }
+
+    m_jwt.setVerificationKey(m_options.jwtKey);
+
+    // Same roles as config.default.ini; explicit permissions cover clients
+    // that have no role definitions
+    m_users = {
+        { 1, "admin",  "admin",  "Ada Admin",   "admin@poc.local",
+          { "admin" },  { "items.read", "items.write", "items.delete" } },
+        { 2, "editor", "editor", "Eddie Editor", "editor@poc.local",
+          { "editor" }, { "items.read", "items.write", "items.delete" } },
+        { 3, "viewer", "viewer", "Vera Viewer",  "viewer@poc.local",
+          { "viewer" }, { "items.read" } },
+    };
+
+    seedItems(m_options.itemCount, m_options.nameLength);
+
+    // Unlike newConnection(), only emitted once a TLS handshake is done
+    connect(m_server, &QTcpServer::pendingConnectionAvailable,
+            this, &MockServer::acceptConnections);
+}
+
+bool MockServer::listen(const QHostAddress& address, quint16 port)
+{
+    return m_server->listen(address, port);
+}
+
+void MockServer::acceptConnections()
+{
+    while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+        auto* connection = new HttpConnection(socket, this);
+        connect(connection, &HttpConnection::requestReceived, this, &MockServer::handle);
+    }
+}
+
+void MockServer::handle(HttpConnection* connection, const HttpRequest& request)
+{
+    int itemId = 0;
+    const auto route = matchRoute(request, itemId);
+    if (!route) {
+        if (m_options.logRequests)
+            qInfo().noquote() << "[MockServer]" << request.method << request.path << "→ 404";
+        connection->respond(error(404, "No such route"));
+        return;
+    }
+
+    const RouteFaults& faults = m_plan->faults(*route);
+    const int delayMs = m_plan->latencyMs(*route);
+    const FaultPlan::Fault fault = m_plan->roll(*route);
+
+    HttpResponse response;
+    switch (fault) {
+    case FaultPlan::NoFault:
+        response = dispatch(*route, request, itemId);
+        break;
+    case FaultPlan::InjectUnauthorized:
+        response = error(401, "Token rejected (injected)");
+        break;
+    case FaultPlan::InjectThrottle:
+        response = error(429, "Too many requests (injected)");
+        response.headers.append({ "Retry-After", QByteArray::number(faults.retryAfterSec) });
+        response.headers.append({ "RateLimit-Remaining", "0" });
+        response.headers.append({ "RateLimit-Reset", QByteArray::number(faults.retryAfterSec) });
+        break;
+    case FaultPlan::InjectUnavailable:
+        response = error(503, "Service unavailable (injected)");
+        response.headers.append({ "Retry-After", QByteArray::number(faults.retryAfterSec) });
+        break;
+    case FaultPlan::InjectError:
+        response = error(500, "Internal error (injected)");
+        break;
+    }
+
+    if (m_options.logRequests) {
+        qInfo().noquote() << "[MockServer]" << request.method << request.path
+                          << "→" << response.status
+                          << "after" << delayMs << "ms,"
+                          << response.body.size() << "bytes"
+                          << (fault != FaultPlan::NoFault ? "(injected)" : "");
+    }
+    connection->respond(std::move(response), delayMs, faults.dripBytes, faults.dripIntervalMs);
+}
+
+HttpResponse MockServer::dispatch(FaultPlan::Route route, const HttpRequest& request, int itemId)
+{
+    if (FaultPlan::needsToken(route) && !authorize(request))
+        return error(401, "Invalid or expired token");
+
+    switch (route) {
+    case FaultPlan::Login:      return login(request);
+    case FaultPlan::Refresh:    return refresh(request);
+    case FaultPlan::Logout:     return logout(request);
+    case FaultPlan::ListItems:  return listItems();
+    case FaultPlan::CreateItem: return createItem(request);
+    case FaultPlan::UpdateItem: return updateItem(itemId, request);
+    case FaultPlan::DeleteItem: return deleteItem(itemId);
+    case FaultPlan::RouteCount: break;
+    }
+    return error(404, "No such route");
+}
+
+HttpResponse MockServer::login(const HttpRequest& request)
+{
+    LoginBody body;
+    if (!JsonCodec::decode(request.body, body))
+        return error(400, "Expected {\"username\", \"password\"}");
+
+    for (const User& user : std::as_const(m_users)) {
+        if (user.username == body.username && user.password == body.password)
+            return issueSession(user);
+    }
+    return error(401, "Invalid username or password");
+}
+
+HttpResponse MockServer::refresh(const HttpRequest& request)
+{
+    RefreshBody body;
+    if (!JsonCodec::decode(request.body, body))
+        return error(400, "Expected {\"refreshToken\"}");
+
+    // Refresh tokens are single use; a new one is issued with the session
+    const auto it = m_refreshTokens.constFind(body.refreshToken);
+    if (it == m_refreshTokens.cend())
+        return error(401, "Unknown refresh token");
+
+    const int index = *it;
+    m_refreshTokens.erase(it);
+    return issueSession(m_users.at(index));
+}
+
+HttpResponse MockServer::logout(const HttpRequest& request)
+{
+    JwtClaims claims;
+    const QString token = QString::fromUtf8(request.header("authorization").sliced(7));
+    m_jwt.decode(token, claims);
+
+    // Every refresh token of the user is revoked
+    for (auto it = m_refreshTokens.begin(); it != m_refreshTokens.end();) {
+        if (QString::number(m_users.at(*it).id) == claims.subject)
+            it = m_refreshTokens.erase(it);
+        else
+            ++it;
+    }
+
+    HttpResponse response;
+    response.status = 204;
+    return response;
+}
+
+HttpResponse MockServer::listItems()
+{
+    if (m_listCache.isEmpty()) {
+        m_listCache.reserve(m_items.size() * (48 + m_options.nameLength));
+        JsonWriter w(m_listCache);
+        w.beginArray();
+        for (auto it = m_items.cbegin(); it != m_items.cend(); ++it) {
+            w.beginObject();
+            w.key("id");
+            w.number(it.key());
+            w.key("name");
+            w.string(it->name);
+            w.key("status");
+            w.string(it->status);
+            w.endObject();
+        }
+        w.endArray();
+    }
+
+    HttpResponse response;
+    response.body = m_listCache;
+    return response;
+}
+
+HttpResponse MockServer::createItem(const HttpRequest& request)
+{
+    ItemBody body;
+    if (!JsonCodec::decode(request.body, body) || body.name.isEmpty())
+        return error(400, "Expected {\"name\", \"status\"}");
+
+    const int id = m_nextItemId++;
+    Item& item = m_items[id];
+    item.name = body.name;
+    item.status = body.status.isEmpty() ? QStringLiteral("active") : body.status;
+    m_listCache.clear();
+
+    HttpResponse response;
+    response.status = 201;
+    response.body = itemJson(id, item);
+    return response;
+}
+
+HttpResponse MockServer::updateItem(int id, const HttpRequest& request)
+{
+    const auto it = m_items.find(id);
+    if (it == m_items.end())
+        return error(404, "No such item");
+
+    ItemBody body;
+    if (!JsonCodec::decode(request.body, body))
+        return error(400, "Expected {\"name\"}");
+
+    if (!body.name.isEmpty()) it->name = body.name;
+    if (!body.status.isEmpty()) it->status = body.status;
+    m_listCache.clear();
+
+    HttpResponse response;
+    response.body = itemJson(id, *it);
+    return response;
+}
+
+HttpResponse MockServer::deleteItem(int id)
+{
+    if (!m_items.remove(id))
+        return error(404, "No such item");
+    m_listCache.clear();
+
+    HttpResponse response;
+    response.status = 204;
+    return response;
+}
+
+bool MockServer::authorize(const HttpRequest& request)
+{
+    const QByteArray header = request.header("authorization");
+    if (!header.startsWith("Bearer ")) return false;
+
+    JwtClaims claims;
+    if (m_jwt.decode(QString::fromUtf8(header.sliced(7)), claims) != JwtDecoder::Ok)
+        return false;
+
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    return claims.expiresAt > now && claims.notBefore <= now;
+}
+
+HttpResponse MockServer::issueSession(const User& user)
+{
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+
+    quint64 random[2];
+    QRandomGenerator::system()->fillRange(random);
+    const QByteArray refreshToken =
+        base64Url(QByteArray::fromRawData(reinterpret_cast<const char*>(random), sizeof random));
+    m_refreshTokens.insert(QString::fromLatin1(refreshToken), int(&user - m_users.constData()));
+
+    UserSession session;
+    session.userId = QString::number(user.id);
+    session.username = user.username;
+    session.displayName = user.displayName;
+    session.email = user.email;
+    session.roles = user.roles;
+    session.permissions = user.permissions;
+
+    HttpResponse response;
+    JsonWriter w(response.body);
+    w.beginObject();
+    w.key("accessToken");
+    w.string(QString::fromLatin1(signToken(user, now)));
+    w.key("refreshToken");
+    w.string(QString::fromLatin1(refreshToken));
+    w.key("expiresIn");
+    w.number(m_options.tokenTtlSec);
+    w.key("user");
+    JsonCodec::write(w, session);
+    w.endObject();
+    return response;
+}
+
+QByteArray MockServer::signToken(const User& user, qint64 now) const
+{
+    JwtClaims claims;
+    claims.subject = QString::number(user.id);
+    claims.username = user.username;
+    claims.displayName = user.displayName;
+    claims.email = user.email;
+    claims.roles = user.roles;
+    claims.permissions = user.permissions;
+    claims.issuedAt = now;
+    claims.notBefore = now;
+    claims.expiresAt = now + m_options.tokenTtlSec;
+
+    QByteArray token = base64Url(R"({"alg":"HS256","typ":"JWT"})") + '.'
+                     + base64Url(JsonCodec::encode(claims));
+    const QByteArray signature =
+        QMessageAuthenticationCode::hash(token, m_options.jwtKey, QCryptographicHash::Sha256);
+    return token + '.' + base64Url(signature);
+}
+
+QByteArray MockServer::itemJson(int id, const Item& item) const
+{
+    QByteArray out;
+    JsonWriter w(out);
+    w.beginObject();
+    w.key("id");
+    w.number(id);
+    w.key("name");
+    w.string(item.name);
+    w.key("status");
+    w.string(item.status);
+    w.endObject();
+    return out;
+}
+
+void MockServer::seedItems(int count, int nameLength)
+{
+    for (int i = 0; i < count; ++i) {
+        const int id = m_nextItemId++;
+        Item& item = m_items[id];
+        item.name = QStringLiteral("Item %1").arg(id);
+        if (item.name.size() < nameLength)
+            item.name = item.name.leftJustified(nameLength, u'.');
+        item.status = QString::fromLatin1(Statuses[i % std::size(Statuses)]);
+    }
+}
+
+HttpResponse MockServer::error(int status, const QString& message)
+{
+    HttpResponse response;
+    response.status = status;
+    JsonWriter w(response.body);
+    w.beginObject();
+    w.key("error");
+    w.string(message);
+    w.endObject();
+    return response;
+}
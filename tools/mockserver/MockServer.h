@@ -0,0 +1,98 @@
+#ifndef MOCKSERVER_H
+#define MOCKSERVER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QSslConfiguration>
+#include <QTcpServer>
+#include "FaultPlan.h"
+#include "HttpConnection.h"
+#include "auth/JwtDecoder.h"
+
+// Offline stand-in for PoCServer.
+//
+// Serves the routes in networking/ApiEndpoints with the payload shapes the
+// client decodes: /auth/login, /auth/refresh and /auth/logout issue and
+// revoke HS256 access tokens plus opaque refresh tokens, and /api/items is
+// an in-memory CRUD collection that can be seeded with synthetic rows.
+// Every response first goes through the FaultPlan for its route, which may
+// replace it with an injected 401/429/503/500, delay it, or drip its body.
+class MockServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        QByteArray jwtKey = "poc-mock-secret";
+        int  tokenTtlSec = 900;
+        int  itemCount = 0;        // synthetic rows seeded at start
+        int  nameLength = 0;       // pad synthetic names to this length
+        bool logRequests = true;
+        QSslConfiguration tls;     // certificate and key for HTTPS; null = HTTP
+    };
+
+    MockServer(const Options& options, FaultPlan* plan, QObject* parent = nullptr);
+
+    bool listen(const QHostAddress& address, quint16 port);
+    QString errorString() const { return m_server->errorString(); }
+    quint16 serverPort() const { return m_server->serverPort(); }
+
+private:
+    struct User
+    {
+        int id;
+        QString username;
+        QString password;
+        QString displayName;
+        QString email;
+        QStringList roles;
+        QStringList permissions;
+    };
+
+    struct Item
+    {
+        QString name;
+        QString status;
+    };
+
+    void acceptConnections();
+    void handle(HttpConnection* connection, const HttpRequest& request);
+    HttpResponse dispatch(FaultPlan::Route route, const HttpRequest& request, int itemId);
+
+    HttpResponse login(const HttpRequest& request);
+    HttpResponse refresh(const HttpRequest& request);
+    HttpResponse logout(const HttpRequest& request);
+    HttpResponse listItems();
+    HttpResponse createItem(const HttpRequest& request);
+    HttpResponse updateItem(int id, const HttpRequest& request);
+    HttpResponse deleteItem(int id);
+
+    bool authorize(const HttpRequest& request);
+    HttpResponse issueSession(const User& user);
+    QByteArray signToken(const User& user, qint64 now) const;
+    QByteArray itemJson(int id, const Item& item) const;
+    void seedItems(int count, int nameLength);
+
+    static HttpResponse error(int status, const QString& message);
+
+    Options        m_options;
+    FaultPlan*     m_plan;
+    QTcpServer*    m_server;         // a QSslServer with Options::tls
+    JwtDecoder     m_jwt;
+
+    QList<User>          m_users;
+    QHash<QString, int>  m_refreshTokens;   // refresh token -> index in m_users
+
+    QMap<int, Item>      m_items;
+    int                  m_nextItemId = 1;
+    QByteArray           m_listCache;       // GET /api/items body, cleared on writes
+};
+
+#endif // MOCKSERVER_H
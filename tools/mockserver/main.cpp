@@ -0,0 +1,173 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QHostAddress>
+#include <QSslCertificate>
+#include <QSslConfiguration>
+#include <QSslKey>
+#include <QSslSocket>
+#include "FaultPlan.h"
+#include "MockServer.h"
+
+namespace {
+
+bool parseRate(const QCommandLineParser& parser, const QString& option, double& out)
+{
+    if (!parser.isSet(option)) return true;
+    bool ok = false;
+    out = parser.value(option).toDouble(&ok);
+    if (ok && out >= 0.0 && out <= 1.0) return true;
+    qCritical().noquote() << "[MockServer] --" + option << "expects a rate between 0 and 1";
+    return false;
+}
+
+bool parseCount(const QCommandLineParser& parser, const QString& option, int& out)
+{
+    if (!parser.isSet(option)) return true;
+    bool ok = false;
+    out = parser.value(option).toInt(&ok);
+    if (ok && out >= 0) return true;
+    qCritical().noquote() << "[MockServer] --" + option << "expects a non-negative integer";
+    return false;
+}
+
+// A self-signed pair for localhost:
+//   openssl req -x509 -newkey rsa:2048 -nodes -days 30 -subj /CN=localhost \
+//       -addext subjectAltName=DNS:localhost,IP:127.0.0.1 -keyout key.pem -out cert.pem
+bool loadTls(const QString& certPath, const QString& keyPath, QSslConfiguration& out)
+{
+    const QList<QSslCertificate> chain = QSslCertificate::fromPath(certPath, QSsl::Pem);
+    if (chain.isEmpty()) {
+        qCritical().noquote() << "[MockServer] no certificate in" << certPath;
+        return false;
+    }
+
+    QFile keyFile(keyPath);
+    if (!keyFile.open(QIODevice::ReadOnly)) {
+        qCritical().noquote() << "[MockServer] cannot read" << keyPath;
+        return false;
+    }
+    const QByteArray pem = keyFile.readAll();
+    QSslKey key;
+    for (QSsl::KeyAlgorithm algorithm : { QSsl::Rsa, QSsl::Ec }) {
+        key = QSslKey(pem, algorithm);
+        if (!key.isNull()) break;
+    }
+    if (key.isNull()) {
+        qCritical().noquote() << "[MockServer] no unencrypted RSA or EC key in" << keyPath;
+        return false;
+    }
+
+    out = QSslConfiguration::defaultConfiguration();
+    out.setLocalCertificateChain(chain);
+    out.setPrivateKey(key);
+    out.setPeerVerifyMode(QSslSocket::VerifyNone);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("PoCMockServer");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Offline stand-in for PoCServer with scriptable latency and faults.\n"
+        "Users: admin/admin, editor/editor, viewer/viewer.\n"
+        "With --tls-cert it serves HTTPS; list the certificate in [network] tlsCaFile.");
+    parser.addHelpOption();
+    parser.addOptions({
+        { "port", "Port to listen on (0 picks a free one).", "port", "7000" },
+        { "listen", "Address to bind.", "address", "127.0.0.1" },
+        { "jwt-key", "HMAC key access tokens are signed with; match [auth] jwtKey.", "key",
+          "poc-mock-secret" },
+        { "token-ttl", "Access token lifetime in seconds.", "seconds", "900" },
+        { "items", "Synthetic items to seed /api/items with.", "count", "0" },
+        { "name-length", "Pad synthetic item names to this many characters.", "chars", "0" },
+        { "seed", "Seed for latency and fault rolls; fixed seeds replay the same run.", "n" },
+        { "latency", "fixed:MS, uniform:MIN,MAX, normal:MEAN,SD or exp:MEAN.", "spec", "none" },
+        { "unauthorized-rate", "Share of token-checked requests answered 401.", "rate" },
+        { "throttle-rate", "Share of requests answered 429 with Retry-After.", "rate" },
+        { "unavailable-rate", "Share of requests answered 503 with Retry-After.", "rate" },
+        { "error-rate", "Share of requests answered 500.", "rate" },
+        { "retry-after", "Retry-After seconds sent with 429 and 503.", "seconds" },
+        { "drip-bytes", "Send response bodies this many bytes at a time.", "bytes" },
+        { "drip-interval", "Milliseconds between body chunks.", "ms" },
+        { "scenario", "INI file with [default] and per-route fault overrides.", "file" },
+        { "tls-cert", "Serve HTTPS with this PEM certificate (chain).", "file" },
+        { "tls-key", "PEM private key for --tls-cert; defaults to the same file.", "file" },
+        { "quiet", "Do not log each request." },
+    });
+    parser.process(app);
+
+    RouteFaults defaults;
+    const auto latency = LatencyModel::parse(parser.value("latency"));
+    if (!latency) {
+        qCritical().noquote() << "[MockServer] cannot parse --latency" << parser.value("latency");
+        return 1;
+    }
+    defaults.latency = *latency;
+
+    MockServer::Options options;
+    options.jwtKey = parser.value("jwt-key").toUtf8();
+    options.logRequests = !parser.isSet("quiet");
+
+    int port = 0;
+    bool ok = parseRate(parser, "unauthorized-rate", defaults.unauthorizedRate)
+           && parseRate(parser, "throttle-rate", defaults.throttleRate)
+           && parseRate(parser, "unavailable-rate", defaults.unavailableRate)
+           && parseRate(parser, "error-rate", defaults.errorRate)
+           && parseCount(parser, "retry-after", defaults.retryAfterSec)
+           && parseCount(parser, "drip-bytes", defaults.dripBytes)
+           && parseCount(parser, "drip-interval", defaults.dripIntervalMs)
+           && parseCount(parser, "token-ttl", options.tokenTtlSec)
+           && parseCount(parser, "items", options.itemCount)
+           && parseCount(parser, "name-length", options.nameLength)
+           && parseCount(parser, "port", port);
+    if (parser.isSet("tls-cert")) {
+        const QString cert = parser.value("tls-cert");
+        ok = ok && loadTls(cert, parser.isSet("tls-key") ? parser.value("tls-key") : cert, options.tls);
+    }
+    if (!ok) return 1;
+    if (port > 65535) {
+        qCritical() << "[MockServer] --port out of range";
+        return 1;
+    }
+
+    FaultPlan plan = parser.isSet("seed") ? FaultPlan(parser.value("seed").toULongLong())
+                                          : FaultPlan();
+    plan.setDefaults(defaults);
+
+    if (parser.isSet("scenario")) {
+        QString error;
+        if (!plan.loadScenario(parser.value("scenario"), error)) {
+            qCritical().noquote() << "[MockServer]" << error;
+            return 1;
+        }
+    }
+
+    MockServer server(options, &plan);
+    const QHostAddress address(parser.value("listen"));
+    if (!server.listen(address, quint16(port))) {
+        qCritical().noquote() << "[MockServer] cannot listen:" << server.errorString();
+        return 1;
+    }
+
+    qInfo().noquote() << "[MockServer] listening on"
+                      << (options.tls.isNull() ? "http://" : "https://") + address.toString() + ':'
+                         + QString::number(server.serverPort())
+                      << "with" << options.itemCount << "items";
+    for (int r = 0; r < FaultPlan::RouteCount; ++r) {
+        const RouteFaults& f = plan.faults(FaultPlan::Route(r));
+        qInfo().noquote() << "[MockServer]" << FaultPlan::routeName(FaultPlan::Route(r))
+                          << "latency" << f.latency.toString()
+                          << "401" << f.unauthorizedRate << "429" << f.throttleRate
+                          << "503" << f.unavailableRate << "500" << f.errorRate
+                          << "drip" << f.dripBytes << "B /" << f.dripIntervalMs << "ms";
+    }
+
+    return app.exec();
+}